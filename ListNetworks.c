@@ -9,8 +9,10 @@
 
 #include <devices/sana2.h>
 #include <devices/sana2specialstats.h>
+#include <devices/timer.h>
 #include <dos/dos.h>
 #include <dos/rdargs.h>
+#include <dos/var.h>
 #include <exec/exec.h>
 #include <exec/types.h>
 #include <exec/errors.h>
@@ -21,8 +23,11 @@
 #include <proto/exec.h>
 #include <proto/dos.h>
 #include <proto/utility.h>
+#include <proto/timer.h>
 #include <clib/alib_protos.h>
 
+#include "ScanDecode.h"
+
 /******************************************************************************
  *
  * NewStyle Device (NSD) definitions
@@ -58,57 +63,6 @@ struct NSDeviceQueryResult
 
 #endif /* NSCMD_DEVICEQUERY */
 
-/******************************************************************************
- *
- * SANA2 Wireless definitions
- * (from devices/sana2wireless.h - not present in all SDK installations)
- *
- ******************************************************************************/
-
-#ifndef S2_GETSIGNALQUALITY
-
-/* Wireless commands */
-#define S2_GETSIGNALQUALITY 0xC010
-#define S2_GETNETWORKS      0xC011
-#define S2_SETOPTIONS       0xC012
-#define S2_SETKEY           0xC013
-#define S2_GETNETWORKINFO   0xC014
-#define S2_READMGMT         0xC015
-#define S2_WRITEMGMT        0xC016
-#define S2_GETCRYPTTYPES    0xC017
-
-/* Tags for getting/setting wireless network info */
-#define S2INFO_SSID             (TAG_USER + 0)
-#define S2INFO_BSSID            (TAG_USER + 1)
-#define S2INFO_AuthTypes        (TAG_USER + 2)
-#define S2INFO_AssocID          (TAG_USER + 3)
-#define S2INFO_Encryption       (TAG_USER + 4)
-#define S2INFO_PortType         (TAG_USER + 5)
-#define S2INFO_BeaconInterval   (TAG_USER + 6)
-#define S2INFO_Channel          (TAG_USER + 7)
-#define S2INFO_Signal           (TAG_USER + 8)
-#define S2INFO_Noise            (TAG_USER + 9)
-#define S2INFO_Capabilities     (TAG_USER + 10)
-#define S2INFO_InfoElements     (TAG_USER + 11)
-#define S2INFO_WPAInfo          (TAG_USER + 12)
-#define S2INFO_Band             (TAG_USER + 13)
-#define S2INFO_DefaultKeyNo     (TAG_USER + 14)
-
-/* Encryption types */
-#define S2ENC_NONE  0
-#define S2ENC_WEP   1
-#define S2ENC_TKIP  2
-#define S2ENC_CCMP  3
-
-/* Signal quality structure */
-struct Sana2SignalQuality
-{
-	LONG SignalLevel;
-	LONG NoiseLevel;
-};
-
-#endif /* S2_GETSIGNALQUALITY */
-
 /******************************************************************************
  *
  * Version string
@@ -125,26 +79,196 @@ static const char * verstag = "$VER: ListNetworks 1.0 (06.02.2026) Renaud Schwei
 
 #define POOLPUDDLESIZE 32768
 #define POOLTHRESHSIZE 32768
-#define MAXDEVICES     16
+#define MAXPROBEUNITS  8
+#define REGISTRYCHUNK  8
+#define REGISTRYDATASIZE 512
+#define REGISTRYNOOFFSET ((ULONG)~0)
+#define DEVICENAMESIZE 256
+#define DEVICECACHEVAR "ListNetworksDevice"
+#define STATUSPOOLSIZE 4096
+#define BASELINECHUNK  64
+
+#define TOPINTERVAL    5     /* default seconds between scans       */
+#define TOPHISTORY     16    /* SNR samples per BSSID, power of two */
+#define TOPMAXAPS      48    /* tracked BSSIDs, LRU evicted beyond  */
+#define TOPROWS        24    /* if the console does not report its size */
+#define TOPCOLS        79    /* never write the last column: no wrap */
+#define TOPHEADROWS    3
+#define TOPMAXROWS     (TOPHEADROWS + TOPMAXAPS + 1)
+#define TOPMAXCOLS     160
+#define TOPBOUNDSWAIT  500000  /* microseconds to wait for the window bounds */
+#define TOPEWMASHIFT   2     /* EWMA weight 1/4 for new samples     */
+#define TOPNOSAMPLE    (-1)
+#define TOPOUTSIZE     4096
+#define TOPLINESIZE    168   /* widest TopRender() line, each %ld as 11 chars */
+
+#define STATSTYPES     3     /* packet types tracked, see StatsTypes */
+#define STATSMAXSPECIAL 32   /* S2_GETSPECIALSTATS records kept     */
+
+#define BENCHNETWORKS  64
+#define BENCHTAGS      12
+#define BENCHPASSES    200
+
+#ifndef AFF_68060
+#define AFF_68060      (1L << 7)
+#endif
 
 #define ITERATE_LIST(list, type, node) \
 	for (node = (type)((struct List *)(list))->lh_Head; \
 	     ((struct Node *)node)->ln_Succ; \
 	     node = (type)((struct Node *)node)->ln_Succ)
 
+/******************************************************************************
+ *
+ * Device registry - the SANA2 devices found by FindSana2Devices()
+ *
+ * Names and NSD command lists share one growable data block.
+ *
+ ******************************************************************************/
+
+struct Sana2DeviceInfo
+{
+	STRPTR  di_Name;
+	UWORD * di_Commands;        /* 0 terminated, NULL if none */
+	UWORD   di_Version;
+	UWORD   di_Revision;
+	UWORD   di_Units;           /* VERBOSE device list only, 0 otherwise */
+	ULONG   di_NameOffset;      /* into dr_Data */
+	ULONG   di_CommandsOffset;
+};
+
+struct DeviceRegistry
+{
+	struct Sana2DeviceInfo * dr_Devices;
+	ULONG                    dr_Count;
+	ULONG                    dr_Size;
+	UBYTE *                  dr_Data;
+	ULONG                    dr_DataUsed;
+	ULONG                    dr_DataSize;
+};
+
+/******************************************************************************
+ *
+ * Baseline (known access point inventory)
+ *
+ ******************************************************************************/
+
+enum {
+	BASELINE_KNOWN = 0,
+	BASELINE_MOVED,
+	BASELINE_SPOOFED,
+	BASELINE_UNKNOWN,
+	BASELINE_COUNT
+};
+
+struct BaselineEntry
+{
+	UBYTE be_BSSID[6];
+	UWORD be_Channel;
+	UBYTE be_SSID[MAXSSIDLEN + 1];
+};
+
+struct Baseline
+{
+	struct BaselineEntry *  bl_Entries;
+	struct BaselineEntry ** bl_ByBSSID;  /* sorted by BSSID */
+	struct BaselineEntry ** bl_BySSID;   /* sorted by SSID  */
+	ULONG                   bl_Count;
+};
+
+typedef LONG (*BaselineCompare)(struct BaselineEntry *, struct BaselineEntry *);
+
+/******************************************************************************
+ *
+ * TOP mode state
+ *
+ * Everything lives in one allocation so the memory used by TOP is fixed.
+ *
+ ******************************************************************************/
+
+struct TopEntry
+{
+	UBYTE te_BSSID[6];
+	UWORD te_Channel;
+	UBYTE te_SSID[MAXSSIDLEN + 1];
+	BYTE  te_History[TOPHISTORY];  /* SNR ring buffer, oldest at te_Head */
+	UWORD te_Head;
+	LONG  te_SNR;
+	LONG  te_EWMA;                 /* SNR in 1/16 dB, TOPNOSAMPLE until the first */
+	LONG  te_ScanEWMA;             /* te_EWMA before this scan's sample */
+	ULONG te_FirstSeen;            /* seconds since TOP started */
+	ULONG te_LastSeen;
+	ULONG te_LastScan;
+};
+
+struct TopState
+{
+	struct TopEntry   ts_Entries[TOPMAXAPS];
+	struct TopEntry * ts_ByBSSID[TOPMAXAPS];
+	struct TopEntry * ts_Display[TOPMAXAPS];
+	ULONG             ts_Count;
+	ULONG             ts_Scans;
+	ULONG             ts_Rows;     /* window size, at most TOPMAXROWS */
+	ULONG             ts_Cols;     /* window width less one, at most TOPMAXCOLS */
+	UBYTE             ts_Frame[TOPMAXROWS][TOPMAXCOLS];
+	UBYTE             ts_Shadow[TOPMAXROWS][TOPMAXCOLS];
+	UBYTE             ts_Out[TOPOUTSIZE];
+	ULONG             ts_OutLen;
+};
+
+/******************************************************************************
+ *
+ * STATS mode state
+ *
+ * Two snapshots of every counter; rates are the difference between them.
+ *
+ ******************************************************************************/
+
+/* Per-type stats flags */
+#define STF_TRACKED    (1 << 0)  /* S2_TRACKTYPE done by us, undone on exit */
+#define STF_AVAILABLE  (1 << 1)
+
+static const ULONG StatsTypes[STATSTYPES] = { 0x0800, 0x0806, 0x86dd };
+static const STRPTR StatsTypeNames[STATSTYPES] = { "IPv4", "ARP", "IPv6" };
+
+struct StatsSnapshot
+{
+	struct DateStamp              sn_Time;
+	struct Sana2DeviceStats       sn_Global;
+	struct Sana2PacketTypeStats   sn_Types[STATSTYPES];
+	struct Sana2SpecialStatHeader sn_SpecialHeader;
+	struct Sana2SpecialStatRecord sn_Special[STATSMAXSPECIAL];  /* must follow the header */
+};
+
+struct StatsState
+{
+	struct StatsSnapshot st_Snapshots[2];  /* previous and current, swapped */
+	UBYTE                st_TypeFlags[STATSTYPES];
+	BOOL                 st_Special;
+};
+
 /******************************************************************************
  *
  * ReadArgs template
  *
  ******************************************************************************/
 
-#define TEMPLATE "DEVICE/K,UNIT/K/N,VERBOSE/S,SHORT/S"
+#define TEMPLATE "DEVICE/K,UNIT/K/N,VERBOSE/S,SHORT/S,BASELINE/K,SAVEBASELINE/K,TOP/S,INTERVAL/K/N,BENCH/S,STATUS/S,MINSNR/K/N,SSID/K,STATS/S"
 
 enum {
 	ARG_DEVICE = 0,
 	ARG_UNIT,
 	ARG_VERBOSE,
 	ARG_SHORT,
+	ARG_BASELINE,
+	ARG_SAVEBASELINE,
+	ARG_TOP,
+	ARG_INTERVAL,
+	ARG_BENCH,
+	ARG_STATUS,
+	ARG_MINSNR,
+	ARG_SSID,
+	ARG_STATS,
 	ARG_COUNT
 };
 
@@ -158,6 +282,17 @@ extern struct ExecBase * SysBase;
 extern struct DosLibrary * DOSBase;
 extern struct Library * UtilityBase;
 
+/******************************************************************************
+ *
+ * Globals
+ *
+ ******************************************************************************/
+
+struct Device * TimerBase = NULL;
+
+/* Scan decoder build for this CPU, see SelectScanDecode() */
+static struct ScanDecodeOps * ScanOps = &ScanDecode000;
+
 /******************************************************************************
  *
  * StrLen()
@@ -171,6 +306,23 @@ static ULONG StrLen(STRPTR s)
 	return (ULONG)(p - s);
 }
 
+/******************************************************************************
+ *
+ * StrCmp()
+ *
+ ******************************************************************************/
+
+static LONG StrCmp(STRPTR a, STRPTR b)
+{
+	while (*a && *a == *b)
+	{
+		a++;
+		b++;
+	}
+
+	return (LONG)*a - (LONG)*b;
+}
+
 /******************************************************************************
  *
  * Strncpy()
@@ -184,6 +336,19 @@ static VOID Strncpy(STRPTR dst, STRPTR src, ULONG len)
 	*dst = 0;
 }
 
+/******************************************************************************
+ *
+ * SPrintf() - RawDoFmt() into a buffer
+ *
+ ******************************************************************************/
+
+static const ULONG stuffChar = 0x16c04e75;  /* move.b d0,(a3)+ ; rts */
+
+static VOID SPrintf(STRPTR buffer, STRPTR format, ...)
+{
+	RawDoFmt(format, (APTR)(&format + 1), (VOID (*)())&stuffChar, buffer);
+}
+
 /******************************************************************************
  *
  * GetEncryptionName()
@@ -259,136 +424,1916 @@ static VOID PrintError(struct IOSana2Req * req)
 		break;
 	}
 
-	PutStr("\n");
+	PutStr("\n");
+}
+
+/******************************************************************************
+ *
+ * IsCommandSupported()
+ *
+ ******************************************************************************/
+
+static BOOL IsCommandSupported(UWORD * commands, UWORD command)
+{
+	if (commands == NULL)
+		return FALSE;
+
+	while (*commands)
+	{
+		if (command == *commands)
+			return TRUE;
+
+		commands++;
+	}
+
+	return FALSE;
+}
+
+/******************************************************************************
+ *
+ * InitDeviceRegistry() / FreeDeviceRegistry()
+ *
+ ******************************************************************************/
+
+static VOID InitDeviceRegistry(struct DeviceRegistry * registry)
+{
+	registry->dr_Devices  = NULL;
+	registry->dr_Count    = 0;
+	registry->dr_Size     = 0;
+	registry->dr_Data     = NULL;
+	registry->dr_DataUsed = 0;
+	registry->dr_DataSize = 0;
+}
+
+static VOID FreeDeviceRegistry(struct DeviceRegistry * registry)
+{
+	if (registry->dr_Devices)
+		FreeVec(registry->dr_Devices);
+
+	if (registry->dr_Data)
+		FreeVec(registry->dr_Data);
+
+	InitDeviceRegistry(registry);
+}
+
+/******************************************************************************
+ *
+ * AddRegistryData() - copy into the shared data block, returns its offset
+ *
+ * Offsets rather than pointers are kept while the block may still move;
+ * FinishDeviceRegistry() resolves them once discovery is over.
+ *
+ ******************************************************************************/
+
+static BOOL AddRegistryData(struct DeviceRegistry * registry, APTR data, ULONG size, ULONG * offset)
+{
+	ULONG start = (registry->dr_DataUsed + 1) & ~1;  /* command lists are UWORDs */
+
+	if (start + size > registry->dr_DataSize)
+	{
+		ULONG  newSize = registry->dr_DataSize ? registry->dr_DataSize : REGISTRYDATASIZE;
+		UBYTE * newData;
+
+		while (newSize < start + size)
+			newSize *= 2;
+
+		if ((newData = AllocVec(newSize, MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+			return FALSE;
+
+		if (registry->dr_Data)
+		{
+			CopyMem(registry->dr_Data, newData, registry->dr_DataUsed);
+			FreeVec(registry->dr_Data);
+		}
+
+		registry->dr_Data     = newData;
+		registry->dr_DataSize = newSize;
+	}
+
+	CopyMem(data, registry->dr_Data + start, size);
+
+	registry->dr_DataUsed = start + size;
+	*offset = start;
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * AddSana2Device() - record an open SANA2 device and its NSD command set
+ *
+ ******************************************************************************/
+
+static struct Sana2DeviceInfo * AddSana2Device(struct DeviceRegistry * registry,
+	struct IOStdReq * io, struct NSDeviceQueryResult * nsdqr)
+{
+	struct Library * library = &io->io_Device->dd_Library;
+	struct Sana2DeviceInfo * info;
+	UWORD * commands = nsdqr->nsdqr_SupportedCommands;
+
+	if (registry->dr_Count == registry->dr_Size)
+	{
+		ULONG newSize = registry->dr_Size ? registry->dr_Size * 2 : REGISTRYCHUNK;
+		struct Sana2DeviceInfo * newDevices;
+
+		if ((newDevices = AllocVec(newSize * sizeof(struct Sana2DeviceInfo), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+			return NULL;
+
+		if (registry->dr_Devices)
+		{
+			CopyMem(registry->dr_Devices, newDevices, registry->dr_Count * sizeof(struct Sana2DeviceInfo));
+			FreeVec(registry->dr_Devices);
+		}
+
+		registry->dr_Devices = newDevices;
+		registry->dr_Size    = newSize;
+	}
+
+	info = &registry->dr_Devices[registry->dr_Count];
+
+	info->di_Name           = NULL;
+	info->di_Commands       = NULL;
+	info->di_Version        = library->lib_Version;
+	info->di_Revision       = library->lib_Revision;
+	info->di_Units          = 0;
+	info->di_CommandsOffset = REGISTRYNOOFFSET;
+
+	if (!AddRegistryData(registry, library->lib_Node.ln_Name,
+		StrLen(library->lib_Node.ln_Name), &info->di_NameOffset))
+	{
+		return NULL;
+	}
+
+	/* The driver's list may go away with the driver, keep a copy */
+
+	if (commands)
+	{
+		ULONG count = 0;
+
+		while (commands[count])
+			count++;
+
+		if (!AddRegistryData(registry, commands, (count + 1) * sizeof(UWORD), &info->di_CommandsOffset))
+			return NULL;
+	}
+
+	registry->dr_Count++;
+
+	return info;
+}
+
+/******************************************************************************
+ *
+ * FinishDeviceRegistry() - turn data block offsets into pointers
+ *
+ ******************************************************************************/
+
+static VOID FinishDeviceRegistry(struct DeviceRegistry * registry)
+{
+	ULONG i;
+
+	for (i = 0; i < registry->dr_Count; i++)
+	{
+		struct Sana2DeviceInfo * info = &registry->dr_Devices[i];
+
+		info->di_Name = registry->dr_Data + info->di_NameOffset;
+
+		if (info->di_CommandsOffset != REGISTRYNOOFFSET)
+			info->di_Commands = (UWORD *)(registry->dr_Data + info->di_CommandsOffset);
+	}
+}
+
+/******************************************************************************
+ *
+ * FindSana2Devices() - enumerate all SANA2 devices in the system
+ *
+ * Each device is opened once: its version and NSD command set are kept in
+ * the registry so main() does not have to ask again.
+ *
+ ******************************************************************************/
+
+static ULONG FindSana2Devices(struct DeviceRegistry * registry)
+{
+	struct Device * device;
+
+	Forbid();
+
+	ITERATE_LIST(&SysBase->DeviceList, struct Device *, device)
+	{
+		struct MsgPort * msgPort;
+
+		if ((msgPort = CreateMsgPort()) != NULL)
+		{
+			struct IOStdReq * io;
+
+			if ((io = (struct IOStdReq *)CreateIORequest(msgPort, 10 * sizeof(struct IOStdReq))) != NULL)
+			{
+				STRPTR deviceName = device->dd_Library.lib_Node.ln_Name;
+
+				Permit();
+
+				if (OpenDevice(deviceName, 0, (struct IORequest *)io, 0) == 0)
+				{
+					struct NSDeviceQueryResult __aligned nsdqr;
+
+					nsdqr.nsdqr_DevQueryFormat    = 0;
+					nsdqr.nsdqr_SizeAvailable     = 0;
+					nsdqr.nsdqr_DeviceType        = 0;
+					nsdqr.nsdqr_DeviceSubType     = 0;
+					nsdqr.nsdqr_SupportedCommands = NULL;
+
+					io->io_Command = NSCMD_DEVICEQUERY;
+					io->io_Data    = &nsdqr;
+					io->io_Length  = sizeof(struct NSDeviceQueryResult);
+
+					if (DoIO((struct IORequest *)io) == 0 && nsdqr.nsdqr_DeviceType == NSDEVTYPE_SANA2)
+						AddSana2Device(registry, io, &nsdqr);
+
+					CloseDevice((struct IORequest *)io);
+				}
+
+				Forbid();
+
+				DeleteIORequest((struct IORequest *)io);
+			}
+
+			DeleteMsgPort(msgPort);
+		}
+	}
+
+	Permit();
+
+	FinishDeviceRegistry(registry);
+
+	return registry->dr_Count;
+}
+
+/******************************************************************************
+ *
+ * CountDeviceUnits() - number of units that open, up to MAXPROBEUNITS
+ *
+ * Opening a unit may bring up the hardware, so this is only done for the
+ * device list printed with VERBOSE, never during discovery.
+ *
+ ******************************************************************************/
+
+static VOID CountDeviceUnits(struct Sana2DeviceInfo * info)
+{
+	struct MsgPort * msgPort;
+	struct IOStdReq * io;
+
+	info->di_Units = 1;  /* unit 0 opened during discovery */
+
+	if ((msgPort = CreateMsgPort()) == NULL)
+		return;
+
+	if ((io = (struct IOStdReq *)CreateIORequest(msgPort, 10 * sizeof(struct IOStdReq))) != NULL)
+	{
+		while (info->di_Units < MAXPROBEUNITS &&
+			OpenDevice(info->di_Name, info->di_Units, (struct IORequest *)io, 0) == 0)
+		{
+			CloseDevice((struct IORequest *)io);
+			info->di_Units++;
+		}
+
+		DeleteIORequest((struct IORequest *)io);
+	}
+
+	DeleteMsgPort(msgPort);
+}
+
+/******************************************************************************
+ *
+ * GetDeviceIndex() - DEVICE=<n> selects the n-th device found, from 1
+ *
+ ******************************************************************************/
+
+static BOOL GetDeviceIndex(STRPTR deviceName, ULONG * index)
+{
+	LONG value;
+	LONG len;
+
+	if (deviceName == NULL || (len = StrToLong(deviceName, &value)) <= 0)
+		return FALSE;
+
+	/* "3com.device" starts with a number but is a name */
+	if (deviceName[len] != 0 || value < 1)
+		return FALSE;
+
+	*index = (ULONG)value;
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * HexDigit()
+ *
+ ******************************************************************************/
+
+static LONG HexDigit(UBYTE c)
+{
+	if (c >= '0' && c <= '9') return (LONG)(c - '0');
+	if (c >= 'a' && c <= 'f') return (LONG)(c - 'a' + 10);
+	if (c >= 'A' && c <= 'F') return (LONG)(c - 'A' + 10);
+	return -1;
+}
+
+/******************************************************************************
+ *
+ * ParseBSSID() - parse "xx:xx:xx:xx:xx:xx", returns pointer past it or NULL
+ *
+ ******************************************************************************/
+
+static STRPTR ParseBSSID(STRPTR s, UBYTE * bssid)
+{
+	ULONG i;
+
+	for (i = 0; i < 6; i++)
+	{
+		LONG hi, lo;
+
+		if ((hi = HexDigit(s[0])) < 0 || (lo = HexDigit(s[1])) < 0)
+			return NULL;
+
+		bssid[i] = (UBYTE)((hi << 4) | lo);
+		s += 2;
+
+		if (i < 5)
+		{
+			if (*s != ':')
+				return NULL;
+
+			s++;
+		}
+	}
+
+	return s;
+}
+
+/******************************************************************************
+ *
+ * CompareBaselineBSSID() / CompareBaselineSSID()
+ *
+ ******************************************************************************/
+
+static LONG CompareBaselineBSSID(struct BaselineEntry * a, struct BaselineEntry * b)
+{
+	ULONG i;
+
+	for (i = 0; i < 6; i++)
+	{
+		if (a->be_BSSID[i] != b->be_BSSID[i])
+			return (LONG)a->be_BSSID[i] - (LONG)b->be_BSSID[i];
+	}
+
+	return 0;
+}
+
+static LONG CompareBaselineSSID(struct BaselineEntry * a, struct BaselineEntry * b)
+{
+	return StrCmp(a->be_SSID, b->be_SSID);
+}
+
+/******************************************************************************
+ *
+ * SortBaseline() - shell sort of an entry index, no recursion or extra memory
+ *
+ ******************************************************************************/
+
+static VOID SortBaseline(struct BaselineEntry ** array, ULONG count, BaselineCompare compare)
+{
+	ULONG gap, i, j;
+
+	for (gap = 1; gap < count / 3; gap = gap * 3 + 1);
+
+	for (; gap > 0; gap /= 3)
+	{
+		for (i = gap; i < count; i++)
+		{
+			struct BaselineEntry * entry = array[i];
+
+			for (j = i; j >= gap && compare(array[j - gap], entry) > 0; j -= gap)
+				array[j] = array[j - gap];
+
+			array[j] = entry;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * SearchBaseline() - binary search in a sorted entry index
+ *
+ ******************************************************************************/
+
+static struct BaselineEntry * SearchBaseline(struct BaselineEntry ** array, ULONG count,
+	struct BaselineEntry * key, BaselineCompare compare)
+{
+	ULONG lo = 0;
+	ULONG hi = count;
+
+	while (lo < hi)
+	{
+		ULONG mid = (lo + hi) >> 1;
+		LONG  cmp = compare(array[mid], key);
+
+		if (cmp == 0)
+			return array[mid];
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *
+ * GetScanEntry() - copy a decoded scan result into a baseline entry
+ *
+ ******************************************************************************/
+
+static BOOL GetScanEntry(struct ScanNetwork * net, struct BaselineEntry * entry)
+{
+	CopyMem(net->sn_BSSID, entry->be_BSSID, 6);
+	CopyMem(net->sn_SSID, entry->be_SSID, MAXSSIDLEN + 1);
+
+	entry->be_Channel = (UWORD)net->sn_Channel;
+
+	return (BOOL)((net->sn_Flags & SNF_BSSID) != 0);
+}
+
+/******************************************************************************
+ *
+ * FreeBaseline()
+ *
+ ******************************************************************************/
+
+static VOID FreeBaseline(struct Baseline * baseline)
+{
+	if (baseline->bl_ByBSSID)
+		FreeVec(baseline->bl_ByBSSID);
+
+	if (baseline->bl_Entries)
+		FreeVec(baseline->bl_Entries);
+
+	baseline->bl_Entries = NULL;
+	baseline->bl_ByBSSID = NULL;
+	baseline->bl_BySSID  = NULL;
+	baseline->bl_Count   = 0;
+}
+
+/******************************************************************************
+ *
+ * LoadBaseline() - read a baseline file and build the BSSID and SSID indexes
+ *
+ * One entry per line: "xx:xx:xx:xx:xx:xx <channel> <ssid>".
+ * Lines starting with ';' or '#' are comments.
+ *
+ ******************************************************************************/
+
+static BOOL LoadBaseline(STRPTR fileName, struct Baseline * baseline)
+{
+	struct BaselineEntry * entries = NULL;
+	ULONG size  = 0;
+	ULONG count = 0;
+	ULONG i;
+	UBYTE line[128];
+	BPTR  fh;
+
+	baseline->bl_Entries = NULL;
+	baseline->bl_ByBSSID = NULL;
+	baseline->bl_BySSID  = NULL;
+	baseline->bl_Count   = 0;
+
+	if ((fh = Open(fileName, MODE_OLDFILE)) == 0)
+		return FALSE;
+
+	while (FGets(fh, line, sizeof(line)) != NULL)
+	{
+		struct BaselineEntry * entry;
+		STRPTR p;
+		LONG   channel;
+		LONG   len;
+
+		if (line[0] == ';' || line[0] == '#' || line[0] == '\n' || line[0] == 0)
+			continue;
+
+		if (count == size)
+		{
+			ULONG newSize = size ? size * 2 : BASELINECHUNK;
+			struct BaselineEntry * newEntries;
+
+			if ((newEntries = AllocVec(newSize * sizeof(struct BaselineEntry), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+			{
+				if (entries)
+					FreeVec(entries);
+
+				Close(fh);
+				return FALSE;
+			}
+
+			if (entries)
+			{
+				CopyMem(entries, newEntries, count * sizeof(struct BaselineEntry));
+				FreeVec(entries);
+			}
+
+			entries = newEntries;
+			size    = newSize;
+		}
+
+		entry = &entries[count];
+
+		if ((p = ParseBSSID(line, entry->be_BSSID)) == NULL ||
+			(len = StrToLong(p, &channel)) <= 0)
+		{
+			Printf("Warning: Skipping malformed baseline line: %s", line);
+			continue;
+		}
+
+		p += len;
+
+		if (*p == ' ')
+			p++;
+
+		Strncpy(entry->be_SSID, p, MAXSSIDLEN);
+
+		for (p = entry->be_SSID; *p; p++)
+		{
+			if (*p == '\n' || *p == '\r')
+			{
+				*p = 0;
+				break;
+			}
+		}
+
+		entry->be_Channel = (UWORD)channel;
+		count++;
+	}
+
+	Close(fh);
+
+	baseline->bl_Entries = entries;
+	baseline->bl_Count   = count;
+
+	if (count == 0)
+		return TRUE;
+
+	/* Both indexes share one allocation */
+
+	if ((baseline->bl_ByBSSID = AllocVec(2 * count * sizeof(struct BaselineEntry *), MEMF_PUBLIC)) == NULL)
+	{
+		FreeBaseline(baseline);
+		return FALSE;
+	}
+
+	baseline->bl_BySSID = baseline->bl_ByBSSID + count;
+
+	for (i = 0; i < count; i++)
+	{
+		baseline->bl_ByBSSID[i] = &entries[i];
+		baseline->bl_BySSID[i]  = &entries[i];
+	}
+
+	ScanOps->sdo_SortByBSSID((APTR *)baseline->bl_ByBSSID, count, OFFSETOF(struct BaselineEntry, be_BSSID));
+	SortBaseline(baseline->bl_BySSID, count, CompareBaselineSSID);
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * SaveBaseline() - write the scan results as a baseline sorted by BSSID
+ *
+ ******************************************************************************/
+
+static BOOL SaveBaseline(STRPTR fileName, APTR * buffer, ULONG numNetworks)
+{
+	struct BaselineEntry *  entries;
+	struct BaselineEntry ** index;
+	ULONG count = 0;
+	ULONG i;
+	BOOL  success = TRUE;
+	BPTR  fh;
+
+	if ((index = AllocVec((numNetworks + 1) * (sizeof(struct BaselineEntry *) + sizeof(struct BaselineEntry)), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+		return FALSE;
+
+	entries = (struct BaselineEntry *)(index + numNetworks + 1);
+
+	for (i = 0; i < numNetworks; i++)
+	{
+		struct ScanNetwork net;
+
+		if (ScanOps->sdo_DecodeNetwork((struct TagItem *)buffer[i], &net) && GetScanEntry(&net, &entries[count]))
+		{
+			index[count] = &entries[count];
+			count++;
+		}
+	}
+
+	ScanOps->sdo_SortByBSSID((APTR *)index, count, OFFSETOF(struct BaselineEntry, be_BSSID));
+
+	if ((fh = Open(fileName, MODE_NEWFILE)) != 0)
+	{
+		FPuts(fh, "; ListNetworks baseline - BSSID channel SSID\n");
+
+		for (i = 0; i < count; i++)
+		{
+			struct BaselineEntry * entry = index[i];
+
+			/* An AP may be reported more than once per scan */
+			if (i > 0 && CompareBaselineBSSID(index[i - 1], entry) == 0)
+				continue;
+
+			if (FPrintf(fh, "%02lx:%02lx:%02lx:%02lx:%02lx:%02lx %ld %s\n",
+				(ULONG)entry->be_BSSID[0], (ULONG)entry->be_BSSID[1],
+				(ULONG)entry->be_BSSID[2], (ULONG)entry->be_BSSID[3],
+				(ULONG)entry->be_BSSID[4], (ULONG)entry->be_BSSID[5],
+				(ULONG)entry->be_Channel,
+				entry->be_SSID) < 0)
+			{
+				success = FALSE;
+				break;
+			}
+		}
+
+		Close(fh);
+	}
+	else
+	{
+		success = FALSE;
+	}
+
+	FreeVec(index);
+
+	return success;
+}
+
+/******************************************************************************
+ *
+ * ClassifyNetwork() - match a scan entry against the baseline, O(log m)
+ *
+ ******************************************************************************/
+
+static ULONG ClassifyNetwork(struct Baseline * baseline, struct BaselineEntry * entry, BOOL hasBSSID)
+{
+	struct BaselineEntry * known;
+
+	if (hasBSSID && (known = SearchBaseline(baseline->bl_ByBSSID, baseline->bl_Count, entry, CompareBaselineBSSID)) != NULL)
+		return (known->be_Channel == entry->be_Channel) ? BASELINE_KNOWN : BASELINE_MOVED;
+
+	/* Unknown BSSID advertising a sanctioned SSID */
+	if (entry->be_SSID[0] && SearchBaseline(baseline->bl_BySSID, baseline->bl_Count, entry, CompareBaselineSSID) != NULL)
+		return BASELINE_SPOOFED;
+
+	return BASELINE_UNKNOWN;
+}
+
+/******************************************************************************
+ *
+ * GetBaselineStatusName()
+ *
+ ******************************************************************************/
+
+static STRPTR GetBaselineStatusName(ULONG status)
+{
+	switch (status)
+	{
+	case BASELINE_KNOWN:   return "known";
+	case BASELINE_MOVED:   return "MOVED";
+	case BASELINE_SPOOFED: return "SPOOFED";
+	case BASELINE_UNKNOWN: return "UNKNOWN";
+	default:               return "?";
+	}
+}
+
+/******************************************************************************
+ *
+ * GetElapsedSeconds()
+ *
+ ******************************************************************************/
+
+static ULONG GetElapsedSeconds(struct DateStamp * start)
+{
+	struct DateStamp now;
+
+	DateStamp(&now);
+
+	return (ULONG)((now.ds_Days - start->ds_Days) * 86400 +
+		(now.ds_Minute - start->ds_Minute) * 60 +
+		(now.ds_Tick - start->ds_Tick) / TICKS_PER_SECOND);
+}
+
+/******************************************************************************
+ *
+ * TopFindEntry() - binary search by BSSID, *pos receives the insert position
+ *
+ ******************************************************************************/
+
+static struct TopEntry * TopFindEntry(struct TopState * state, UBYTE * bssid, ULONG * pos)
+{
+	ULONG lo = 0;
+	ULONG hi = state->ts_Count;
+
+	while (lo < hi)
+	{
+		ULONG mid = (lo + hi) >> 1;
+		UBYTE * key = state->ts_ByBSSID[mid]->te_BSSID;
+		LONG  cmp = 0;
+		ULONG i;
+
+		for (i = 0; i < 6 && cmp == 0; i++)
+			cmp = (LONG)key[i] - (LONG)bssid[i];
+
+		if (cmp == 0)
+		{
+			*pos = mid;
+			return state->ts_ByBSSID[mid];
+		}
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	*pos = lo;
+	return NULL;
+}
+
+/******************************************************************************
+ *
+ * TopAddEntry() - insert a BSSID at pos, evicting the least recently seen
+ *
+ ******************************************************************************/
+
+static struct TopEntry * TopAddEntry(struct TopState * state, UBYTE * bssid, ULONG pos, ULONG now)
+{
+	struct TopEntry * entry;
+	ULONG i;
+
+	if (state->ts_Count == TOPMAXAPS)
+	{
+		ULONG victim = 0;
+
+		for (i = 1; i < state->ts_Count; i++)
+		{
+			if (state->ts_ByBSSID[i]->te_LastScan < state->ts_ByBSSID[victim]->te_LastScan)
+				victim = i;
+		}
+
+		entry = state->ts_ByBSSID[victim];
+
+		for (i = victim; i + 1 < state->ts_Count; i++)
+			state->ts_ByBSSID[i] = state->ts_ByBSSID[i + 1];
+
+		state->ts_Count--;
+
+		if (victim < pos)
+			pos--;
+	}
+	else
+	{
+		entry = &state->ts_Entries[state->ts_Count];
+	}
+
+	for (i = state->ts_Count; i > pos; i--)
+		state->ts_ByBSSID[i] = state->ts_ByBSSID[i - 1];
+
+	state->ts_ByBSSID[pos] = entry;
+	state->ts_Count++;
+
+	for (i = 0; i < 6; i++)
+		entry->te_BSSID[i] = bssid[i];
+
+	for (i = 0; i < TOPHISTORY; i++)
+		entry->te_History[i] = TOPNOSAMPLE;
+
+	entry->te_Head      = 0;
+	entry->te_SNR       = 0;
+	entry->te_EWMA      = TOPNOSAMPLE;
+	entry->te_ScanEWMA  = TOPNOSAMPLE;
+	entry->te_FirstSeen = now;
+	entry->te_LastSeen  = now;
+	entry->te_LastScan  = 0;
+
+	return entry;
+}
+
+/******************************************************************************
+ *
+ * TopPushSample() - append one SNR sample to the ring buffer and the EWMA
+ *
+ ******************************************************************************/
+
+static VOID TopPushSample(struct TopEntry * entry, LONG snr, BOOL repeat)
+{
+	/* An AP reported twice in one scan replaces its own sample, average included */
+
+	if (repeat)
+	{
+		entry->te_Head = (entry->te_Head - 1) & (TOPHISTORY - 1);
+		entry->te_EWMA = entry->te_ScanEWMA;
+	}
+	else
+	{
+		entry->te_ScanEWMA = entry->te_EWMA;
+	}
+
+	entry->te_History[entry->te_Head] = (BYTE)snr;
+	entry->te_Head = (entry->te_Head + 1) & (TOPHISTORY - 1);
+
+	if (snr == TOPNOSAMPLE)
+		return;
+
+	if (entry->te_EWMA == TOPNOSAMPLE)
+		entry->te_EWMA = snr << 4;
+	else
+		entry->te_EWMA += ((snr << 4) - entry->te_EWMA) / (1 << TOPEWMASHIFT);
+
+	entry->te_SNR = snr;
+}
+
+/******************************************************************************
+ *
+ * TopUpdate() - merge one scan into the tracked BSSIDs
+ *
+ ******************************************************************************/
+
+static VOID TopUpdate(struct TopState * state, APTR * buffer, ULONG numNetworks, ULONG now)
+{
+	ULONG scan = ++state->ts_Scans;
+	ULONG i;
+
+	for (i = 0; i < numNetworks; i++)
+	{
+		struct ScanNetwork net;
+		struct TopEntry * entry;
+		ULONG  pos;
+		LONG   snr;
+
+		if (!ScanOps->sdo_DecodeNetwork((struct TagItem *)buffer[i], &net) || !(net.sn_Flags & SNF_BSSID))
+			continue;
+
+		snr = net.sn_Signal - net.sn_Noise;
+
+		if (snr < 0)  snr = 0;
+		if (snr > 99) snr = 99;
+
+		if ((entry = TopFindEntry(state, net.sn_BSSID, &pos)) == NULL)
+			entry = TopAddEntry(state, net.sn_BSSID, pos, now);
+
+		TopPushSample(entry, snr, (BOOL)(entry->te_LastScan == scan));
+
+		entry->te_Channel  = (UWORD)net.sn_Channel;
+		entry->te_LastSeen = now;
+		entry->te_LastScan = scan;
+
+		CopyMem(net.sn_SSID, entry->te_SSID, MAXSSIDLEN + 1);
+	}
+
+	/* Leave a gap in the trend of every BSSID missing from this scan */
+
+	for (i = 0; i < state->ts_Count; i++)
+	{
+		if (state->ts_ByBSSID[i]->te_LastScan != scan)
+			TopPushSample(state->ts_ByBSSID[i], TOPNOSAMPLE, FALSE);
+	}
+}
+
+/******************************************************************************
+ *
+ * TopSetRow() - copy text into a frame row, padded with spaces
+ *
+ ******************************************************************************/
+
+static VOID TopSetRow(struct TopState * state, ULONG row, STRPTR text)
+{
+	UBYTE * cell = state->ts_Frame[row];
+	ULONG col;
+
+	for (col = 0; col < state->ts_Cols && text[col]; col++)
+		cell[col] = text[col];
+
+	for (; col < state->ts_Cols; col++)
+		cell[col] = ' ';
+}
+
+/******************************************************************************
+ *
+ * TopRender() - build the next frame
+ *
+ ******************************************************************************/
+
+static VOID TopRender(struct TopState * state, STRPTR deviceName, ULONG unitNumber,
+	ULONG interval, ULONG now)
+{
+	static const UBYTE spark[] = ".:-=+*#%@";
+	UBYTE line[TOPLINESIZE];
+	ULONG count = state->ts_Count;
+	ULONG row, i, j;
+
+	/* Strongest average first */
+
+	for (i = 0; i < count; i++)
+	{
+		struct TopEntry * entry = state->ts_ByBSSID[i];
+
+		for (j = i; j > 0 && state->ts_Display[j - 1]->te_EWMA < entry->te_EWMA; j--)
+			state->ts_Display[j] = state->ts_Display[j - 1];
+
+		state->ts_Display[j] = entry;
+	}
+
+	SPrintf(line, " %.32s unit %ld | scan %ld every %lds | %ld/%ld BSSIDs | up %ld:%02ld",
+		deviceName, unitNumber, state->ts_Scans, interval,
+		count, (ULONG)TOPMAXAPS, now / 60, now % 60);
+	TopSetRow(state, 0, line);
+	TopSetRow(state, 1, " BSSID             Chn  SNR   Avg Trend             First   Last SSID");
+	TopSetRow(state, 2, "-------------------------------------------------------------------------------");
+
+	for (row = TOPHEADROWS; row < state->ts_Rows - 1; row++)
+	{
+		struct TopEntry * entry;
+		UBYTE trend[TOPHISTORY + 1];
+		ULONG k;
+
+		if (row - TOPHEADROWS >= count)
+		{
+			TopSetRow(state, row, "");
+			continue;
+		}
+
+		entry = state->ts_Display[row - TOPHEADROWS];
+
+		for (k = 0; k < TOPHISTORY; k++)
+		{
+			LONG sample = entry->te_History[(entry->te_Head + k) & (TOPHISTORY - 1)];
+			LONG level  = sample * (LONG)(sizeof(spark) - 1) / 50;
+
+			if (level >= (LONG)(sizeof(spark) - 1))
+				level = sizeof(spark) - 2;
+
+			trend[k] = (sample == TOPNOSAMPLE) ? ' ' : spark[level];
+		}
+
+		trend[TOPHISTORY] = 0;
+
+		SPrintf(line, " %02lx:%02lx:%02lx:%02lx:%02lx:%02lx %3ld %4ld %3ld.%ld %s %3ld:%02ld %3ld:%02ld %.14s",
+			(ULONG)entry->te_BSSID[0], (ULONG)entry->te_BSSID[1],
+			(ULONG)entry->te_BSSID[2], (ULONG)entry->te_BSSID[3],
+			(ULONG)entry->te_BSSID[4], (ULONG)entry->te_BSSID[5],
+			(ULONG)entry->te_Channel,
+			entry->te_SNR,
+			entry->te_EWMA >> 4, ((entry->te_EWMA & 15) * 10) >> 4,
+			trend,
+			entry->te_FirstSeen / 60, entry->te_FirstSeen % 60,
+			entry->te_LastSeen / 60, entry->te_LastSeen % 60,
+			entry->te_SSID);
+		TopSetRow(state, row, line);
+	}
+
+	TopSetRow(state, state->ts_Rows - 1, " Press CTRL-C to quit");
+}
+
+/******************************************************************************
+ *
+ * TopEmit() - append to the output buffer, flushing it when full
+ *
+ ******************************************************************************/
+
+static VOID TopEmit(struct TopState * state, UBYTE * data, ULONG len)
+{
+	if (state->ts_OutLen + len > TOPOUTSIZE)
+	{
+		Write(Output(), state->ts_Out, state->ts_OutLen);
+		state->ts_OutLen = 0;
+	}
+
+	CopyMem(data, &state->ts_Out[state->ts_OutLen], len);
+	state->ts_OutLen += len;
+}
+
+/******************************************************************************
+ *
+ * TopPaint() - send only the cells that differ from what is on screen
+ *
+ * Runs of changed cells separated by a few unchanged ones are merged,
+ * as rewriting them is cheaper than another cursor positioning sequence.
+ *
+ ******************************************************************************/
+
+static VOID TopPaint(struct TopState * state)
+{
+	UBYTE csi[16];
+	ULONG row, col;
+
+	for (row = 0; row < state->ts_Rows; row++)
+	{
+		UBYTE * frame  = state->ts_Frame[row];
+		UBYTE * shadow = state->ts_Shadow[row];
+
+		for (col = 0; col < state->ts_Cols; col++)
+		{
+			ULONG start, end;
+
+			if (frame[col] == shadow[col])
+				continue;
+
+			start = col;
+			end   = col + 1;
+
+			for (col++; col < state->ts_Cols && col < end + 6; col++)
+			{
+				if (frame[col] != shadow[col])
+					end = col + 1;
+			}
+
+			SPrintf(csi, "\x1b[%ld;%ldH", row + 1, start + 1);
+			TopEmit(state, csi, StrLen(csi) - 1);
+			TopEmit(state, &frame[start], end - start);
+			CopyMem(&frame[start], &shadow[start], end - start);
+
+			col = end;
+		}
+	}
+
+	/* Park the cursor on the bottom line */
+	SPrintf(csi, "\x1b[%ld;1H", state->ts_Rows);
+	TopEmit(state, csi, StrLen(csi) - 1);
+
+	Write(Output(), state->ts_Out, state->ts_OutLen);
+	state->ts_OutLen = 0;
+}
+
+/******************************************************************************
+ *
+ * TopGetWindowSize() - ask the console for its size (CSI 0 q)
+ *
+ * The console answers CSI 1;1;<rows>;<cols> r on its input, so the
+ * input is switched to raw mode while waiting for it. Anything typed in
+ * the meantime is dropped. FALSE if not a console or no answer came.
+ *
+ ******************************************************************************/
+
+static BOOL TopGetWindowSize(ULONG * rows, ULONG * cols)
+{
+	BPTR   in  = Input();
+	BPTR   out = Output();
+	UBYTE  reply[32];
+	UBYTE * p;
+	LONG   field[4];
+	ULONG  len = 0;
+	ULONG  i;
+
+	if (!IsInteractive(in) || !IsInteractive(out))
+		return FALSE;
+
+	Flush(out);
+	SetMode(in, 1);
+	Write(out, "\x1b[0 q", 5);
+
+	while (len < sizeof(reply) - 1 && WaitForChar(in, TOPBOUNDSWAIT))
+	{
+		if (Read(in, &reply[len], 1) != 1)
+			break;
+
+		if (reply[len++] == 'r')
+			break;
+	}
+
+	SetMode(in, 0);
+
+	if (len == 0 || reply[len - 1] != 'r')
+		return FALSE;
+
+	reply[len] = 0;
+
+	/* The report starts after the last CSI, 0x9b or ESC [ */
+
+	for (p = &reply[len - 1]; p > reply && *p != 0x9b && *p != '['; p--)
+		;
+
+	if (*p != 0x9b && *p != '[')
+		return FALSE;
+
+	p++;
+
+	for (i = 0; i < 4; i++)
+	{
+		LONG n;
+
+		if ((n = StrToLong(p, &field[i])) <= 0)
+			return FALSE;
+
+		p += n;
+
+		if (i < 3 && *p++ != ';')
+			return FALSE;
+	}
+
+	if (field[2] <= 0 || field[3] <= 0)
+		return FALSE;
+
+	*rows = (ULONG)field[2];
+	*cols = (ULONG)field[3];
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * WaitInterval() - sleep interval seconds, FALSE if CTRL-C came first
+ *
+ ******************************************************************************/
+
+static BOOL WaitInterval(ULONG interval)
+{
+	ULONG tick;
+
+	for (tick = 0; tick < interval * TICKS_PER_SECOND; tick += TICKS_PER_SECOND / 5)
+	{
+		if (CheckSignal(SIGBREAKF_CTRL_C))
+			return FALSE;
+
+		Delay(TICKS_PER_SECOND / 5);
+	}
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * RunTopMode() - rescan every interval and repaint until CTRL-C
+ *
+ ******************************************************************************/
+
+static ULONG RunTopMode(struct IOSana2Req * s2req, STRPTR deviceName, ULONG unitNumber, ULONG interval)
+{
+	struct TopState * state;
+	struct DateStamp start;
+	ULONG result = RETURN_OK;
+	ULONG row, col;
+
+	if ((state = AllocVec(sizeof(struct TopState), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+	{
+		PutStr("Error: Cannot allocate TOP state.\n");
+		return RETURN_FAIL;
+	}
+
+	if (!TopGetWindowSize(&state->ts_Rows, &state->ts_Cols))
+	{
+		state->ts_Rows = TOPROWS;
+		state->ts_Cols = TOPCOLS + 1;
+	}
+
+	/* Room for the header, the footer and no more than we can track */
+
+	if (state->ts_Rows < TOPHEADROWS + 1)
+		state->ts_Rows = TOPHEADROWS + 1;
+
+	if (state->ts_Rows > TOPMAXROWS)
+		state->ts_Rows = TOPMAXROWS;
+
+	if (--state->ts_Cols > TOPMAXCOLS)
+		state->ts_Cols = TOPMAXCOLS;
+
+	/* Clear the window once, later frames only touch changed cells */
+
+	for (row = 0; row < state->ts_Rows; row++)
+		for (col = 0; col < state->ts_Cols; col++)
+			state->ts_Shadow[row][col] = ' ';
+
+	PutStr("\x1b[H\x1b[J");
+
+	DateStamp(&start);
+
+	for (;;)
+	{
+		APTR  poolHeader;
+
+		if ((poolHeader = CreatePool(MEMF_PUBLIC | MEMF_CLEAR, POOLPUDDLESIZE, POOLTHRESHSIZE)) == NULL)
+		{
+			PutStr("Error: Cannot allocate memory pool.\n");
+			result = RETURN_FAIL;
+			break;
+		}
+
+		s2req->ios2_Req.io_Command = S2_GETNETWORKS;
+		s2req->ios2_Data = poolHeader;
+
+		if (DoIO((struct IORequest *)s2req) == S2ERR_NO_ERROR)
+		{
+			ULONG now = GetElapsedSeconds(&start);
+
+			APTR * buffer = (APTR *)s2req->ios2_StatData;
+
+			TopUpdate(state, buffer, ScanOps->sdo_CheckScanResults(buffer, s2req->ios2_DataLength), now);
+			TopRender(state, deviceName, unitNumber, interval, now);
+			TopPaint(state);
+		}
+		else
+		{
+			PutStr("\x1b[H\x1b[J\nError: Failed to scan for networks.\n");
+			PrintError(s2req);
+			DeletePool(poolHeader);
+			result = RETURN_ERROR;
+			break;
+		}
+
+		DeletePool(poolHeader);
+
+		if (!WaitInterval(interval))
+			break;
+	}
+
+	PutStr("\n");
+
+	FreeVec(state);
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * GetElapsedTicks() - ticks from one DateStamp to a later one
+ *
+ ******************************************************************************/
+
+static ULONG GetElapsedTicks(struct DateStamp * from, struct DateStamp * to)
+{
+	return (ULONG)(((to->ds_Days - from->ds_Days) * 1440 +
+		(to->ds_Minute - from->ds_Minute)) * 60 * TICKS_PER_SECOND +
+		(to->ds_Tick - from->ds_Tick));
+}
+
+/******************************************************************************
+ *
+ * ScaleCount() - count * mul / div without overflowing 32 bits
+ *
+ * Used for per-second rates (mul = TICKS_PER_SECOND, div = ticks) and
+ * per-mille ratios, so mul * div stays well inside a ULONG.
+ *
+ ******************************************************************************/
+
+static ULONG ScaleCount(ULONG count, ULONG mul, ULONG div)
+{
+	if (div == 0)
+		return 0;
+
+	return (count / div) * mul + (count % div) * mul / div;
+}
+
+/******************************************************************************
+ *
+ * StatsSample() - read all counters of the device into one sample
+ *
+ * Global stats are required; per-type and special stats are dropped for
+ * the rest of the run the first time the driver refuses them.
+ *
+ ******************************************************************************/
+
+static BOOL StatsSample(struct IOSana2Req * s2req, struct StatsState * state, struct StatsSnapshot * snap)
+{
+	ULONG i;
+
+	s2req->ios2_Req.io_Command = S2_GETGLOBALSTATS;
+	s2req->ios2_StatData = &snap->sn_Global;
+
+	if (DoIO((struct IORequest *)s2req) != S2ERR_NO_ERROR)
+		return FALSE;
+
+	DateStamp(&snap->sn_Time);
+
+	for (i = 0; i < STATSTYPES; i++)
+	{
+		if (!(state->st_TypeFlags[i] & STF_AVAILABLE))
+			continue;
+
+		s2req->ios2_Req.io_Command = S2_GETTYPESTATS;
+		s2req->ios2_PacketType = StatsTypes[i];
+		s2req->ios2_StatData = &snap->sn_Types[i];
+
+		if (DoIO((struct IORequest *)s2req) != S2ERR_NO_ERROR)
+			state->st_TypeFlags[i] &= ~STF_AVAILABLE;
+	}
+
+	snap->sn_SpecialHeader.RecordCountMax      = STATSMAXSPECIAL;
+	snap->sn_SpecialHeader.RecordCountSupplied = 0;
+
+	if (state->st_Special)
+	{
+		s2req->ios2_Req.io_Command = S2_GETSPECIALSTATS;
+		s2req->ios2_StatData = &snap->sn_SpecialHeader;
+
+		if (DoIO((struct IORequest *)s2req) != S2ERR_NO_ERROR)
+			state->st_Special = FALSE;
+		else if (snap->sn_SpecialHeader.RecordCountSupplied > STATSMAXSPECIAL)
+			snap->sn_SpecialHeader.RecordCountSupplied = STATSMAXSPECIAL;
+	}
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * StatsPrint() - rates between two samples
+ *
+ * Counters are ULONGs that may wrap: the unsigned difference is still
+ * right as long as they wrap at most once per interval.
+ *
+ ******************************************************************************/
+
+static VOID StatsPrint(struct StatsState * state, struct StatsSnapshot * prev, struct StatsSnapshot * cur,
+	ULONG elapsed)
+{
+	struct Sana2DeviceStats * a = &prev->sn_Global;
+	struct Sana2DeviceStats * b = &cur->sn_Global;
+	ULONG ticks = GetElapsedTicks(&prev->sn_Time, &cur->sn_Time);
+	ULONG received, bad, overruns;
+	ULONG i, j;
+
+	Printf("\n[%5lu s]\n", elapsed);
+
+	if (ticks == 0)
+		ticks = 1;
+
+	received = b->PacketsReceived - a->PacketsReceived;
+	bad      = b->BadData - a->BadData;
+	overruns = b->Overruns - a->Overruns;
+
+	Printf("  Packets  : %lu/s in, %lu/s out\n",
+		ScaleCount(received, TICKS_PER_SECOND, ticks),
+		ScaleCount(b->PacketsSent - a->PacketsSent, TICKS_PER_SECOND, ticks));
+
+	Printf("  Errors   : %lu/s bad data, %lu/s overruns, %lu/s unknown type\n",
+		ScaleCount(bad, TICKS_PER_SECOND, ticks),
+		ScaleCount(overruns, TICKS_PER_SECOND, ticks),
+		ScaleCount(b->UnknownTypesReceived - a->UnknownTypesReceived, TICKS_PER_SECOND, ticks));
+
+	/* Per mille of everything that arrived, good or not */
+
+	if (received + bad + overruns > 0)
+	{
+		ULONG total = received + bad + overruns;
+		ULONG badPM, overPM;
+
+		/* Keep total * 1000 inside a ULONG, the ratio barely changes */
+
+		while (total > 0x100000)
+		{
+			total    >>= 1;
+			bad      >>= 1;
+			overruns >>= 1;
+		}
+
+		badPM  = ScaleCount(bad, 1000, total);
+		overPM = ScaleCount(overruns, 1000, total);
+
+		Printf("  Loss     : %lu.%lu%% bad data, %lu.%lu%% overruns\n",
+			badPM / 10, badPM % 10, overPM / 10, overPM % 10);
+	}
+
+	for (i = 0; i < STATSTYPES; i++)
+	{
+		struct Sana2PacketTypeStats * ta = &prev->sn_Types[i];
+		struct Sana2PacketTypeStats * tb = &cur->sn_Types[i];
+
+		if (!(state->st_TypeFlags[i] & STF_AVAILABLE))
+			continue;
+
+		Printf("  %-9s: %lu B/s in, %lu B/s out, %lu/s dropped\n", StatsTypeNames[i],
+			ScaleCount(tb->BytesReceived - ta->BytesReceived, TICKS_PER_SECOND, ticks),
+			ScaleCount(tb->BytesSent - ta->BytesSent, TICKS_PER_SECOND, ticks),
+			ScaleCount(tb->PacketsDropped - ta->PacketsDropped, TICKS_PER_SECOND, ticks));
+	}
+
+	/* Special stats are matched by type, the driver may add records */
+
+	for (i = 0; i < cur->sn_SpecialHeader.RecordCountSupplied; i++)
+	{
+		struct Sana2SpecialStatRecord * rb = &cur->sn_Special[i];
+		ULONG before = rb->Count;
+
+		for (j = 0; j < prev->sn_SpecialHeader.RecordCountSupplied; j++)
+		{
+			if (prev->sn_Special[j].Type == rb->Type)
+			{
+				before = prev->sn_Special[j].Count;
+				break;
+			}
+		}
+
+		if (rb->String)
+			Printf("  %s: ", rb->String);
+		else
+			Printf("  $%08lx: ", rb->Type);
+
+		Printf("%lu/s (%lu total)\n", ScaleCount(rb->Count - before, TICKS_PER_SECOND, ticks), rb->Count);
+	}
+}
+
+/******************************************************************************
+ *
+ * RunStatsMode() - sample the adapter counters every interval until CTRL-C
+ *
+ ******************************************************************************/
+
+static ULONG RunStatsMode(struct IOSana2Req * s2req, STRPTR deviceName, ULONG unitNumber, ULONG interval)
+{
+	struct StatsState * state;
+	struct DateStamp start;
+	ULONG result = RETURN_OK;
+	ULONG cur = 0;
+	ULONG i;
+
+	if ((state = AllocVec(sizeof(struct StatsState), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+	{
+		PutStr("Error: Cannot allocate STATS state.\n");
+		return RETURN_FAIL;
+	}
+
+	/* Ask for per-type counters; a type someone else tracks is fine too */
+
+	for (i = 0; i < STATSTYPES; i++)
+	{
+		s2req->ios2_Req.io_Command = S2_TRACKTYPE;
+		s2req->ios2_PacketType = StatsTypes[i];
+
+		if (DoIO((struct IORequest *)s2req) == S2ERR_NO_ERROR)
+			state->st_TypeFlags[i] = STF_TRACKED | STF_AVAILABLE;
+		else if (s2req->ios2_WireError == S2WERR_ALREADY_TRACKED)
+			state->st_TypeFlags[i] = STF_AVAILABLE;
+	}
+
+	state->st_Special = TRUE;
+
+	DateStamp(&start);
+
+	if (!StatsSample(s2req, state, &state->st_Snapshots[cur]))
+	{
+		PutStr("\nError: Cannot read device statistics.\n");
+		PrintError(s2req);
+		result = RETURN_ERROR;
+		goto stats_cleanup;
+	}
+
+	Printf("\nSampling %s unit %lu every %lu s. Press CTRL-C to stop.\n", deviceName, unitNumber, interval);
+
+	while (WaitInterval(interval))
+	{
+		struct StatsSnapshot * prev = &state->st_Snapshots[cur];
+		struct StatsSnapshot * next = &state->st_Snapshots[cur ^ 1];
+
+		if (!StatsSample(s2req, state, next))
+		{
+			PutStr("\nError: Cannot read device statistics.\n");
+			PrintError(s2req);
+			result = RETURN_ERROR;
+			break;
+		}
+
+		/* A restarted device starts its counters again from zero */
+
+		if (next->sn_Global.LastStart.tv_secs  != prev->sn_Global.LastStart.tv_secs ||
+			next->sn_Global.LastStart.tv_micro != prev->sn_Global.LastStart.tv_micro)
+		{
+			Printf("\n[%5lu s]\n  Device restarted, counters reset.\n", GetElapsedSeconds(&start));
+		}
+		else
+		{
+			StatsPrint(state, prev, next, GetElapsedSeconds(&start));
+		}
+
+		cur ^= 1;
+	}
+
+stats_cleanup:
+
+	for (i = 0; i < STATSTYPES; i++)
+	{
+		if (state->st_TypeFlags[i] & STF_TRACKED)
+		{
+			s2req->ios2_Req.io_Command = S2_UNTRACKTYPE;
+			s2req->ios2_PacketType = StatsTypes[i];
+			DoIO((struct IORequest *)s2req);
+		}
+	}
+
+	FreeVec(state);
+
+	return result;
+}
+
+/******************************************************************************
+ *
+ * SelectScanDecode() - pick the scan decoder build for the CPU we run on
+ *
+ ******************************************************************************/
+
+static struct ScanDecodeOps * SelectScanDecode(VOID)
+{
+	UWORD attnFlags = SysBase->AttnFlags;
+
+	if (attnFlags & AFF_68060)
+		return &ScanDecode060;
+
+	/* Also set on the 68030 and 68040 */
+	if (attnFlags & AFF_68020)
+		return &ScanDecode020;
+
+	return &ScanDecode000;
+}
+
+/******************************************************************************
+ *
+ * Benchmark data - a synthetic scan, the same for every decoder build
+ *
+ ******************************************************************************/
+
+struct BenchData
+{
+	struct TagItem     bd_Tags[BENCHNETWORKS][BENCHTAGS];
+	UBYTE              bd_SSID[BENCHNETWORKS][MAXSSIDLEN + 1];
+	UBYTE              bd_BSSID[BENCHNETWORKS][6];
+	APTR               bd_Buffer[BENCHNETWORKS];
+	struct ScanNetwork bd_Networks[BENCHNETWORKS];
+	APTR               bd_Sorted[BENCHNETWORKS];
+	UBYTE              bd_Row[SCANROWSIZE];
+};
+
+/******************************************************************************
+ *
+ * InitBenchData()
+ *
+ ******************************************************************************/
+
+static VOID InitBenchData(struct BenchData * bench)
+{
+	ULONG seed = 0x2545f491;
+	ULONG i, j;
+
+	for (i = 0; i < BENCHNETWORKS; i++)
+	{
+		struct TagItem * tags = bench->bd_Tags[i];
+		ULONG len;
+
+		for (j = 0; j < 6; j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			bench->bd_BSSID[i][j] = (UBYTE)(seed >> 16);
+		}
+
+		len = 4 + (seed >> 8) % (MAXSSIDLEN - 4);
+
+		for (j = 0; j < len; j++)
+			bench->bd_SSID[i][j] = (UBYTE)('a' + (i + j) % 26);
+
+		bench->bd_SSID[i][len] = 0;
+
+		/* Roughly what a driver returns, SSID and BSSID not first */
+
+		tags[0].ti_Tag  = S2INFO_Capabilities;   tags[0].ti_Data  = 0x0411;
+		tags[1].ti_Tag  = S2INFO_BeaconInterval; tags[1].ti_Data  = 100;
+		tags[2].ti_Tag  = S2INFO_Encryption;     tags[2].ti_Data  = S2ENC_CCMP;
+		tags[3].ti_Tag  = S2INFO_InfoElements;   tags[3].ti_Data  = 0;
+		tags[4].ti_Tag  = S2INFO_WPAInfo;        tags[4].ti_Data  = 0;
+		tags[5].ti_Tag  = S2INFO_BSSID;          tags[5].ti_Data  = (ULONG)bench->bd_BSSID[i];
+		tags[6].ti_Tag  = S2INFO_SSID;           tags[6].ti_Data  = (ULONG)bench->bd_SSID[i];
+		tags[7].ti_Tag  = S2INFO_Channel;        tags[7].ti_Data  = 1 + i % 13;
+		tags[8].ti_Tag  = S2INFO_Signal;         tags[8].ti_Data  = (ULONG)(-40 - (LONG)(i % 50));
+		tags[9].ti_Tag  = S2INFO_Noise;          tags[9].ti_Data  = (ULONG)-95;
+		tags[10].ti_Tag = S2INFO_Band;           tags[10].ti_Data = i & 1;
+		tags[11].ti_Tag = TAG_DONE;              tags[11].ti_Data = 0;
+
+		bench->bd_Buffer[i] = tags;
+	}
 }
 
 /******************************************************************************
  *
- * IsCommandSupported()
+ * RunBenchPass() - decode, format and sort the synthetic scan once
  *
  ******************************************************************************/
 
-static BOOL IsCommandSupported(struct NSDeviceQueryResult * nsdqr, UWORD command)
+static VOID RunBenchPass(struct ScanDecodeOps * ops, struct BenchData * bench)
 {
-	UWORD * commands;
-
-	if (nsdqr == NULL || nsdqr->nsdqr_SupportedCommands == NULL)
-		return FALSE;
-
-	commands = nsdqr->nsdqr_SupportedCommands;
+	ULONG count = ops->sdo_CheckScanResults(bench->bd_Buffer, BENCHNETWORKS);
+	ULONG i;
 
-	while (*commands)
+	for (i = 0; i < count; i++)
 	{
-		if (command == *commands)
-			return TRUE;
-
-		commands++;
+		ops->sdo_DecodeNetwork((struct TagItem *)bench->bd_Buffer[i], &bench->bd_Networks[i]);
+		ops->sdo_FormatNetworkRow(&bench->bd_Networks[i], bench->bd_Row);
+		bench->bd_Sorted[i] = &bench->bd_Networks[i];
 	}
 
-	return FALSE;
+	ops->sdo_SortByBSSID(bench->bd_Sorted, count, OFFSETOF(struct ScanNetwork, sn_BSSID));
 }
 
 /******************************************************************************
  *
- * FindSana2Devices() - enumerate all SANA2 devices in the system
+ * RunBenchmark() - time every decoder build this CPU can run
  *
  ******************************************************************************/
 
-static ULONG FindSana2Devices(STRPTR * nameArray, ULONG maxDevices)
+static ULONG RunBenchmark(VOID)
 {
-	struct Device * device;
-	ULONG count = 0;
+	struct ScanDecodeOps * builds[3];
+	ULONG required[3];
+	ULONG baseTime = 0;
+	ULONG result = RETURN_FAIL;
+	struct MsgPort * port;
+	struct timerequest * timeReq = NULL;
+	struct BenchData * bench = NULL;
+	ULONG i, pass;
 
-	Forbid();
+	builds[0] = &ScanDecode000; required[0] = 0;
+	builds[1] = &ScanDecode020; required[1] = AFF_68020;
+	builds[2] = &ScanDecode060; required[2] = AFF_68060;
 
-	ITERATE_LIST(&SysBase->DeviceList, struct Device *, device)
+	if ((port = CreateMsgPort()) == NULL)
 	{
-		struct MsgPort * msgPort;
+		PutStr("Error: Cannot create message port.\n");
+		return RETURN_FAIL;
+	}
 
-		if ((msgPort = CreateMsgPort()) != NULL)
+	if ((timeReq = (struct timerequest *)CreateIORequest(port, sizeof(struct timerequest))) == NULL ||
+		OpenDevice(TIMERNAME, UNIT_ECLOCK, (struct IORequest *)timeReq, 0) != 0)
+	{
+		PutStr("Error: Cannot open timer.device.\n");
+		goto bench_cleanup;
+	}
+
+	TimerBase = timeReq->tr_node.io_Device;
+
+	if ((bench = AllocVec(sizeof(struct BenchData), MEMF_PUBLIC | MEMF_CLEAR)) == NULL)
+	{
+		PutStr("Error: Cannot allocate benchmark data.\n");
+		goto bench_cleanup;
+	}
+
+	InitBenchData(bench);
+
+	Printf("\nBenchmark: %ld networks x %ld passes (decode, format, sort)\n\n",
+		(ULONG)BENCHNETWORKS, (ULONG)BENCHPASSES);
+
+	for (i = 0; i < 3; i++)
+	{
+		struct EClockVal start, end;
+		ULONG freq;
+		ULONG ms;
+
+		if ((SysBase->AttnFlags & required[i]) != required[i])
 		{
-			struct IOStdReq * io;
+			Printf("  %s : needs a %s or better\n", builds[i]->sdo_Name, builds[i]->sdo_Name);
+			continue;
+		}
 
-			if ((io = (struct IOStdReq *)CreateIORequest(msgPort, 10 * sizeof(struct IOStdReq))) != NULL)
-			{
-				STRPTR deviceName = device->dd_Library.lib_Node.ln_Name;
+		freq = ReadEClock(&start);
 
-				Permit();
+		for (pass = 0; pass < BENCHPASSES; pass++)
+			RunBenchPass(builds[i], bench);
 
-				if (OpenDevice(deviceName, 0, (struct IORequest *)io, 0) == 0)
-				{
-					struct NSDeviceQueryResult __aligned nsdqr;
+		ReadEClock(&end);
 
-					nsdqr.nsdqr_DevQueryFormat    = 0;
-					nsdqr.nsdqr_SizeAvailable     = 0;
-					nsdqr.nsdqr_DeviceType        = 0;
-					nsdqr.nsdqr_DeviceSubType     = 0;
-					nsdqr.nsdqr_SupportedCommands = NULL;
+		ms = (end.ev_lo - start.ev_lo) / (freq / 1000);
 
-					io->io_Command = NSCMD_DEVICEQUERY;
-					io->io_Data    = &nsdqr;
-					io->io_Length  = sizeof(struct NSDeviceQueryResult);
+		if (ms == 0)
+			ms = 1;
 
-					if (DoIO((struct IORequest *)io) == 0)
-					{
-						if (nsdqr.nsdqr_DeviceType == NSDEVTYPE_SANA2)
-						{
-							ULONG nameLen = StrLen(deviceName);
-
-							if (nameLen > 0)
-							{
-								if (nameArray[count] = AllocVec(nameLen, MEMF_PUBLIC | MEMF_CLEAR))
-								{
-									Strncpy(nameArray[count], deviceName, nameLen);
-									count++;
-
-									if (count >= maxDevices)
-									{
-										CloseDevice((struct IORequest *)io);
-										DeleteIORequest((struct IORequest *)io);
-										DeleteMsgPort(msgPort);
-										return count;
-									}
-								}
-							}
-						}
-					}
+		if (baseTime == 0)
+			baseTime = ms;
 
-					CloseDevice((struct IORequest *)io);
-				}
+		Printf("  %s : %6ld ms  %ld.%02ldx%s\n",
+			builds[i]->sdo_Name, ms,
+			baseTime / ms, (baseTime % ms) * 100 / ms,
+			(builds[i] == ScanOps) ? "  (selected)" : "");
 
-				Forbid();
+		if (CheckSignal(SIGBREAKF_CTRL_C))
+			break;
+	}
 
-				DeleteIORequest((struct IORequest *)io);
-			}
+	result = RETURN_OK;
 
-			DeleteMsgPort(msgPort);
-		}
+bench_cleanup:
+
+	if (bench)
+		FreeVec(bench);
+
+	if (timeReq)
+	{
+		if (TimerBase)
+			CloseDevice((struct IORequest *)timeReq);
+
+		DeleteIORequest((struct IORequest *)timeReq);
 	}
 
-	Permit();
+	TimerBase = NULL;
+
+	DeleteMsgPort(port);
 
-	return count;
+	return result;
 }
 
 /******************************************************************************
  *
- * FreeSana2DeviceNames()
+ * GetCachedDevice() / SetCachedDevice() - last auto-detected device in ENV:
  *
  ******************************************************************************/
 
-static VOID FreeSana2DeviceNames(STRPTR * nameArray, ULONG count)
+static BOOL GetCachedDevice(STRPTR buffer, ULONG size)
 {
-	ULONG i;
+	return (BOOL)(GetVar(DEVICECACHEVAR, buffer, size, GVF_GLOBAL_ONLY) > 0);
+}
 
-	for (i = 0; i < count; i++)
+static VOID SetCachedDevice(STRPTR deviceName)
+{
+	UBYTE current[DEVICENAMESIZE];
+
+	/* Only touch ENV: when the auto-detected device changes */
+
+	if (GetCachedDevice(current, sizeof(current)) && StrCmp(current, deviceName) == 0)
+		return;
+
+	SetVar(DEVICECACHEVAR, deviceName, -1, GVF_GLOBAL_ONLY);
+}
+
+/******************************************************************************
+ *
+ * RunStatusMode() - one line link status from S2_GETNETWORKINFO and
+ * S2_GETSIGNALQUALITY, both sent at once, no NSD query and no scan
+ *
+ * Returns OK when associated, WARN when below MINSNR or on another SSID,
+ * ERROR when not associated and FAIL when the device cannot be used.
+ *
+ ******************************************************************************/
+
+static ULONG RunStatusMode(STRPTR deviceName, ULONG unitNumber, LONG minSNR, STRPTR wantSSID)
+{
+	struct DeviceRegistry registry;
+	UBYTE  cachedName[DEVICENAMESIZE];
+	BOOL   cached = FALSE;
+	ULONG  result = RETURN_FAIL;
+
+	struct MsgPort * msgPort = NULL;
+	struct IOSana2Req * infoReq = NULL;
+	struct IOSana2Req * sigReq = NULL;
+	struct Sana2SignalQuality __aligned sigQuality;
+	struct ScanNetwork net;
+	APTR   poolHeader = NULL;
+	BYTE   infoError, sigError;
+	LONG   snr = 0;
+	BOOL   haveSNR = TRUE;
+	ULONG  deviceIndex = 1;
+	BOOL   byIndex;
+
+	InitDeviceRegistry(&registry);
+
+	/* DEVICE=, then the cached device, then discovery as a last resort */
+
+	byIndex = GetDeviceIndex(deviceName, &deviceIndex);
+
+	if (deviceName == NULL && (cached = GetCachedDevice(cachedName, sizeof(cachedName))))
+		deviceName = cachedName;
+
+	if (deviceName == NULL || byIndex)
 	{
-		if (nameArray[i])
+		if (FindSana2Devices(&registry) < deviceIndex)
 		{
-			FreeVec(nameArray[i]);
-			nameArray[i] = NULL;
+			PutStr("NODEVICE\n");
+			FreeDeviceRegistry(&registry);
+			return RETURN_FAIL;
 		}
+
+		deviceName = registry.dr_Devices[deviceIndex - 1].di_Name;
+
+		if (!byIndex)
+			SetCachedDevice(deviceName);
+	}
+
+	if ((msgPort = CreateMsgPort()) == NULL ||
+		(infoReq = (struct IOSana2Req *)CreateIORequest(msgPort, sizeof(struct IOSana2Req))) == NULL ||
+		(sigReq = (struct IOSana2Req *)CreateIORequest(msgPort, sizeof(struct IOSana2Req))) == NULL ||
+		(poolHeader = CreatePool(MEMF_PUBLIC | MEMF_CLEAR, STATUSPOOLSIZE, STATUSPOOLSIZE)) == NULL)
+	{
+		PutStr("Error: Cannot allocate resources.\n");
+		goto status_cleanup;
+	}
+
+	if (OpenDevice(deviceName, unitNumber, (struct IORequest *)infoReq, 0) != 0)
+	{
+		Printf("Error: Cannot open device '%s' unit %ld.\n", deviceName, unitNumber);
+		infoReq->ios2_Req.io_Device = NULL;
+
+		/* Forget a stale cache entry, the next call will rediscover */
+		if (cached)
+			DeleteVar(DEVICECACHEVAR, GVF_GLOBAL_ONLY);
+
+		goto status_cleanup;
+	}
+
+	CopyMem(infoReq, sigReq, sizeof(struct IOSana2Req));
+
+	infoReq->ios2_Req.io_Command = S2_GETNETWORKINFO;
+	infoReq->ios2_Data = poolHeader;
+
+	sigReq->ios2_Req.io_Command = S2_GETSIGNALQUALITY;
+	sigReq->ios2_StatData = &sigQuality;
+
+	SendIO((struct IORequest *)infoReq);
+	SendIO((struct IORequest *)sigReq);
+
+	infoError = WaitIO((struct IORequest *)infoReq);
+	sigError  = WaitIO((struct IORequest *)sigReq);
+
+	if (infoError == IOERR_NOCMD)
+	{
+		PutStr("Error: Device does not support S2_GETNETWORKINFO.\n");
+
+		/* Not a usable cache entry either */
+		if (cached)
+			DeleteVar(DEVICECACHEVAR, GVF_GLOBAL_ONLY);
+
+		goto status_cleanup;
+	}
+
+	if (infoError != S2ERR_NO_ERROR ||
+		!ScanOps->sdo_DecodeNetwork((struct TagItem *)infoReq->ios2_StatData, &net) ||
+		!(net.sn_Flags & SNF_BSSID))
+	{
+		PutStr("DOWN\n");
+		result = RETURN_ERROR;
+		goto status_cleanup;
+	}
+
+	result = RETURN_OK;
+
+	/* Without either source the decoder defaults would read as 0 dB */
+
+	if (sigError == S2ERR_NO_ERROR)
+		snr = sigQuality.SignalLevel - sigQuality.NoiseLevel;
+	else if ((net.sn_Flags & (SNF_SIGNAL | SNF_NOISE)) == (SNF_SIGNAL | SNF_NOISE))
+		snr = net.sn_Signal - net.sn_Noise;
+	else
+		haveSNR = FALSE;
+
+	/* Compare the bytes the driver sent, UTF-8 SSIDs are not printable as is */
+
+	if (wantSSID && StrCmp(net.sn_RawSSID, wantSSID) != 0)
+	{
+		PutStr("WRONGSSID");
+		result = RETURN_WARN;
+	}
+	else if (haveSNR && minSNR >= 0 && snr < minSNR)
+	{
+		PutStr("LOWSNR");
+		result = RETURN_WARN;
+	}
+	else
+	{
+		PutStr("UP");
+	}
+
+	Printf(" \"%s\" %02lx:%02lx:%02lx:%02lx:%02lx:%02lx chan %ld",
+		net.sn_SSID,
+		(ULONG)net.sn_BSSID[0], (ULONG)net.sn_BSSID[1],
+		(ULONG)net.sn_BSSID[2], (ULONG)net.sn_BSSID[3],
+		(ULONG)net.sn_BSSID[4], (ULONG)net.sn_BSSID[5],
+		net.sn_Channel);
+
+	if (haveSNR)
+		Printf(" SNR %ld dB\n", snr);
+	else
+		PutStr(" SNR unknown\n");
+
+status_cleanup:
+
+	if (poolHeader)
+		DeletePool(poolHeader);
+
+	if (sigReq)
+		DeleteIORequest((struct IORequest *)sigReq);
+
+	if (infoReq)
+	{
+		if (infoReq->ios2_Req.io_Device)
+			CloseDevice((struct IORequest *)infoReq);
+
+		DeleteIORequest((struct IORequest *)infoReq);
 	}
+
+	if (msgPort)
+		DeleteMsgPort(msgPort);
+
+	FreeDeviceRegistry(&registry);
+
+	return result;
 }
 
 /******************************************************************************
@@ -397,8 +2342,11 @@ static VOID FreeSana2DeviceNames(STRPTR * nameArray, ULONG count)
  *
  ******************************************************************************/
 
-static VOID PrintSeparator(VOID)
+static VOID PrintSeparator(BOOL withStatus)
 {
+	if (withStatus)
+		PutStr("---------+");
+
 	PutStr("---------+-------------------+------+----------+--------\n");
 }
 
@@ -408,12 +2356,16 @@ static VOID PrintSeparator(VOID)
  *
  ******************************************************************************/
 
-static VOID PrintNetworkHeader(VOID)
+static VOID PrintNetworkHeader(BOOL withStatus)
 {
 	PutStr("\n");
-	PrintSeparator();
+	PrintSeparator(withStatus);
+
+	if (withStatus)
+		PutStr(" Status  |");
+
 	PutStr(" Signal  | BSSID             | Chan | Band     | SSID\n");
-	PrintSeparator();
+	PrintSeparator(withStatus);
 }
 
 /******************************************************************************
@@ -432,9 +2384,24 @@ ULONG main(ULONG argc, STRPTR * argv)
 	ULONG  unitNumber = 0;
 	BOOL   verbose    = FALSE;
 	BOOL   shortMode  = FALSE;
-
-	STRPTR deviceNames[MAXDEVICES];
-	ULONG  deviceCount = 0;
+	BOOL   topMode    = FALSE;
+	BOOL   benchMode  = FALSE;
+	BOOL   statusMode = FALSE;
+	BOOL   statsMode  = FALSE;
+	LONG   minSNR     = -1;
+	STRPTR wantSSID   = NULL;
+	ULONG  interval   = TOPINTERVAL;
+
+	STRPTR baselineFile     = NULL;
+	STRPTR saveBaselineFile = NULL;
+	struct Baseline baseline;
+	ULONG  statusCount[BASELINE_COUNT];
+
+	struct DeviceRegistry registry;
+	struct Sana2DeviceInfo * deviceInfo = NULL;
+	UWORD * commands;
+	ULONG  deviceIndex = 1;
+	BOOL   byIndex;
 	ULONG  i;
 
 	struct MsgPort * msgPort = NULL;
@@ -448,6 +2415,16 @@ ULONG main(ULONG argc, STRPTR * argv)
 	for (i = 0; i < ARG_COUNT; i++)
 		args[i] = 0;
 
+	for (i = 0; i < BASELINE_COUNT; i++)
+		statusCount[i] = 0;
+
+	baseline.bl_Entries = NULL;
+	baseline.bl_ByBSSID = NULL;
+	baseline.bl_BySSID  = NULL;
+	baseline.bl_Count   = 0;
+
+	InitDeviceRegistry(&registry);
+
 	/* Parse command line arguments */
 
 	if ((rdargs = ReadArgs(TEMPLATE, args, NULL)) != NULL)
@@ -460,6 +2437,20 @@ ULONG main(ULONG argc, STRPTR * argv)
 
 		verbose = (BOOL)args[ARG_VERBOSE];
 		shortMode = (BOOL)args[ARG_SHORT];
+		topMode   = (BOOL)args[ARG_TOP];
+		benchMode = (BOOL)args[ARG_BENCH];
+		statusMode = (BOOL)args[ARG_STATUS];
+		statsMode  = (BOOL)args[ARG_STATS];
+		wantSSID   = (STRPTR)args[ARG_SSID];
+
+		if (args[ARG_MINSNR])
+			minSNR = *((LONG *)args[ARG_MINSNR]);
+
+		if (args[ARG_INTERVAL] && *((LONG *)args[ARG_INTERVAL]) > 0)
+			interval = *((LONG *)args[ARG_INTERVAL]);
+
+		baselineFile     = (STRPTR)args[ARG_BASELINE];
+		saveBaselineFile = (STRPTR)args[ARG_SAVEBASELINE];
 	}
 	else
 	{
@@ -467,40 +2458,102 @@ ULONG main(ULONG argc, STRPTR * argv)
 		return RETURN_ERROR;
 	}
 
+	ScanOps = SelectScanDecode();
+
+	/* STATUS prints a single line, nothing else */
+
+	if (statusMode)
+	{
+		result = RunStatusMode(deviceName, unitNumber, minSNR, wantSSID);
+		FreeArgs(rdargs);
+		return result;
+	}
+
 	if (!shortMode)
 		PutStr("ListNetworks 1.0 - Wireless network scanner for AmigaOS\n");
 
-	/* If no device specified, find all SANA2 devices and list them */
+	if (verbose)
+		Printf("Using %s scan decoder.\n", ScanOps->sdo_Name);
+
+	if (benchMode)
+	{
+		result = RunBenchmark();
+		FreeArgs(rdargs);
+		return result;
+	}
+
+	/* Load the known access point inventory before touching the device */
 
-	if (deviceName == NULL)
+	if (baselineFile)
 	{
+		if (!LoadBaseline(baselineFile, &baseline))
+		{
+			Printf("Error: Cannot load baseline '%s'.\n", baselineFile);
+			FreeArgs(rdargs);
+			return RETURN_ERROR;
+		}
+
 		if (!shortMode)
-			PutStr("\nScanning for SANA2 network devices...\n\n");
+			Printf("Loaded %ld known access point(s) from %s\n", baseline.bl_Count, baselineFile);
+	}
+
+	/* If no device or a device number is given, find all SANA2 devices */
 
-		deviceCount = FindSana2Devices(deviceNames, MAXDEVICES);
+	byIndex = GetDeviceIndex(deviceName, &deviceIndex);
+
+	if (deviceName == NULL || byIndex)
+	{
+		if (!shortMode)
+			PutStr("\nScanning for SANA2 network devices...\n\n");
 
-		if (deviceCount == 0)
+		if (FindSana2Devices(&registry) == 0)
 		{
 			PutStr("No SANA2 network devices found.\n");
+			FreeDeviceRegistry(&registry);
+			FreeBaseline(&baseline);
 			FreeArgs(rdargs);
 			return RETURN_WARN;
 		}
 
 		if (!shortMode)
 		{
-			Printf("Found %ld SANA2 device(s):\n\n", deviceCount);
+			Printf("Found %ld SANA2 device(s):\n\n", registry.dr_Count);
 
-			for (i = 0; i < deviceCount; i++)
+			for (i = 0; i < registry.dr_Count; i++)
 			{
-				Printf("  %ld: %s\n", i + 1, deviceNames[i]);
+				struct Sana2DeviceInfo * info = &registry.dr_Devices[i];
+
+				Printf("  %ld: %s %ld.%ld", i + 1, info->di_Name,
+					(ULONG)info->di_Version, (ULONG)info->di_Revision);
+
+				if (verbose)
+				{
+					CountDeviceUnits(info);
+					Printf(" (%ld unit%s)", (ULONG)info->di_Units, (info->di_Units == 1) ? "" : "s");
+				}
+
+				PutStr("\n");
 			}
 		}
 
-		/* Use the first device found by default */
-		deviceName = deviceNames[0];
+		if (deviceIndex > registry.dr_Count)
+		{
+			Printf("Error: There is no device %ld.\n", deviceIndex);
+			result = RETURN_ERROR;
+			goto cleanup;
+		}
+
+		deviceInfo = &registry.dr_Devices[deviceIndex - 1];
+		deviceName = deviceInfo->di_Name;
 
-		if (!shortMode)
-			PutStr("\nUsing first device. Use DEVICE=<n> to specify another.\n");
+		if (!byIndex)
+		{
+			/* Use the first device found by default */
+			SetCachedDevice(deviceName);
+
+			if (!shortMode)
+				PutStr("\nUsing first device. Use DEVICE=<n> to specify another.\n");
+		}
 	}
 
 	/* Open the SANA2 device */
@@ -526,22 +2579,31 @@ ULONG main(ULONG argc, STRPTR * argv)
 		goto cleanup;
 	}
 
-	/* NSD query to verify it's a SANA2 device */
+	/* Discovery already did the NSD query, otherwise verify it's a SANA2 device */
 
-	nsdqr.nsdqr_DevQueryFormat    = 0;
-	nsdqr.nsdqr_SizeAvailable     = 0;
-	nsdqr.nsdqr_DeviceType        = 0;
-	nsdqr.nsdqr_DeviceSubType     = 0;
-	nsdqr.nsdqr_SupportedCommands = NULL;
+	if (deviceInfo)
+	{
+		commands = deviceInfo->di_Commands;
+	}
+	else
+	{
+		nsdqr.nsdqr_DevQueryFormat    = 0;
+		nsdqr.nsdqr_SizeAvailable     = 0;
+		nsdqr.nsdqr_DeviceType        = 0;
+		nsdqr.nsdqr_DeviceSubType     = 0;
+		nsdqr.nsdqr_SupportedCommands = NULL;
 
-	ioReq->io_Command = NSCMD_DEVICEQUERY;
-	ioReq->io_Data    = &nsdqr;
-	ioReq->io_Length  = sizeof(struct NSDeviceQueryResult);
+		ioReq->io_Command = NSCMD_DEVICEQUERY;
+		ioReq->io_Data    = &nsdqr;
+		ioReq->io_Length  = sizeof(struct NSDeviceQueryResult);
 
-	if (DoIO((struct IORequest *)ioReq) != 0 || nsdqr.nsdqr_DeviceType != NSDEVTYPE_SANA2)
-	{
-		PutStr("Error: Device is not a SANA2 network device.\n");
-		goto cleanup;
+		if (DoIO((struct IORequest *)ioReq) != 0 || nsdqr.nsdqr_DeviceType != NSDEVTYPE_SANA2)
+		{
+			PutStr("Error: Device is not a SANA2 network device.\n");
+			goto cleanup;
+		}
+
+		commands = nsdqr.nsdqr_SupportedCommands;
 	}
 
 	if (!shortMode)
@@ -595,7 +2657,7 @@ ULONG main(ULONG argc, STRPTR * argv)
 		}
 
 		/* S2_GETSIGNALQUALITY */
-		if (IsCommandSupported(&nsdqr, S2_GETSIGNALQUALITY))
+		if (IsCommandSupported(commands, S2_GETSIGNALQUALITY))
 		{
 			s2req->ios2_Req.io_Command = S2_GETSIGNALQUALITY;
 			s2req->ios2_StatData = &sigQuality;
@@ -610,7 +2672,7 @@ ULONG main(ULONG argc, STRPTR * argv)
 		}
 
 		/* S2_GETNETWORKINFO - show current connected network */
-		if (IsCommandSupported(&nsdqr, S2_GETNETWORKINFO))
+		if (IsCommandSupported(commands, S2_GETNETWORKINFO))
 		{
 			poolHeader = CreatePool(MEMF_PUBLIC | MEMF_CLEAR, POOLPUDDLESIZE, POOLTHRESHSIZE);
 
@@ -621,28 +2683,23 @@ ULONG main(ULONG argc, STRPTR * argv)
 
 				if (DoIO((struct IORequest *)s2req) == S2ERR_NO_ERROR)
 				{
-					struct TagItem * tags;
+					struct ScanNetwork net;
 
-					if (tags = (struct TagItem *)s2req->ios2_StatData)
+					if (ScanOps->sdo_DecodeNetwork((struct TagItem *)s2req->ios2_StatData, &net))
 					{
-						UBYTE * bssid = (UBYTE *)GetTagData(S2INFO_BSSID, 0, tags);
-
 						PutStr("\nConnected network:\n");
-						Printf("  SSID     : %s\n",
-							GetTagData(S2INFO_SSID, 0, tags));
+						Printf("  SSID     : %s\n", net.sn_SSID);
 
-						if (bssid)
+						if (net.sn_Flags & SNF_BSSID)
 						{
 							Printf("  BSSID    : %02lx:%02lx:%02lx:%02lx:%02lx:%02lx\n",
-								(ULONG)bssid[0], (ULONG)bssid[1],
-								(ULONG)bssid[2], (ULONG)bssid[3],
-								(ULONG)bssid[4], (ULONG)bssid[5]);
+								(ULONG)net.sn_BSSID[0], (ULONG)net.sn_BSSID[1],
+								(ULONG)net.sn_BSSID[2], (ULONG)net.sn_BSSID[3],
+								(ULONG)net.sn_BSSID[4], (ULONG)net.sn_BSSID[5]);
 						}
 
-						Printf("  Channel  : %ld\n",
-							GetTagData(S2INFO_Channel, 0, tags));
-						Printf("  Band     : %sGHz\n",
-							GetTagData(S2INFO_Band, 0, tags) ? "2.4" : "5");
+						Printf("  Channel  : %ld\n", net.sn_Channel);
+						Printf("  Band     : %sGHz\n", net.sn_Band ? "2.4" : "5");
 					}
 				}
 
@@ -652,7 +2709,7 @@ ULONG main(ULONG argc, STRPTR * argv)
 		}
 
 		/* S2_GETCRYPTTYPES */
-		if (IsCommandSupported(&nsdqr, S2_GETCRYPTTYPES))
+		if (IsCommandSupported(commands, S2_GETCRYPTTYPES))
 		{
 			poolHeader = CreatePool(MEMF_PUBLIC | MEMF_CLEAR, POOLPUDDLESIZE, POOLTHRESHSIZE);
 
@@ -682,9 +2739,17 @@ ULONG main(ULONG argc, STRPTR * argv)
 		}
 	}
 
+	/* STATS needs no wireless commands, only the standard counters */
+
+	if (statsMode)
+	{
+		result = RunStatsMode((struct IOSana2Req *)ioReq, deviceName, unitNumber, interval);
+		goto cleanup;
+	}
+
 	/* Scan for available wireless networks using S2_GETNETWORKS */
 
-	if (!IsCommandSupported(&nsdqr, S2_GETNETWORKS))
+	if (!IsCommandSupported(commands, S2_GETNETWORKS))
 	{
 		PutStr("\nThis device does not support wireless network scanning.\n");
 		PutStr("(S2_GETNETWORKS command not available)\n");
@@ -692,6 +2757,12 @@ ULONG main(ULONG argc, STRPTR * argv)
 		goto cleanup;
 	}
 
+	if (topMode)
+	{
+		result = RunTopMode((struct IOSana2Req *)ioReq, deviceName, unitNumber, interval);
+		goto cleanup;
+	}
+
 	poolHeader = CreatePool(MEMF_PUBLIC | MEMF_CLEAR, POOLPUDDLESIZE, POOLTHRESHSIZE);
 
 	if (poolHeader == NULL)
@@ -711,10 +2782,20 @@ ULONG main(ULONG argc, STRPTR * argv)
 
 		if (DoIO((struct IORequest *)s2req) == S2ERR_NO_ERROR)
 		{
-			ULONG numNetworks = s2req->ios2_DataLength;
 			APTR * buffer = (APTR *)s2req->ios2_StatData;
+			ULONG numNetworks = ScanOps->sdo_CheckScanResults(buffer, s2req->ios2_DataLength);
+			ULONG numEmpty = 0;
+			ULONG numTruncated = 0;
+
+			/* Results without a tag list cannot be decoded, leave them out of the count */
+
+			for (i = 0; i < numNetworks; i++)
+			{
+				if (buffer[i] == NULL)
+					numEmpty++;
+			}
 
-			if (numNetworks == 0)
+			if (numNetworks == numEmpty)
 			{
 				PutStr("\nNo wireless networks found.\n");
 			}
@@ -724,58 +2805,102 @@ ULONG main(ULONG argc, STRPTR * argv)
 				{
 					for (i = 0; i < numNetworks; i++)
 					{
-						struct TagItem * tags = (struct TagItem *)buffer[i];
+						struct ScanNetwork net;
+
+						if (!ScanOps->sdo_DecodeNetwork((struct TagItem *)buffer[i], &net))
+							continue;
+
+						Printf("%s (%s GHz)",
+							(net.sn_Flags & SNF_SSID) ? net.sn_SSID : (UBYTE *)"<hidden>",
+							net.sn_Band ? "2.4" : "5");
 
-						STRPTR ssid = (STRPTR)GetTagData(S2INFO_SSID, (ULONG)"<hidden>", tags);
-						ULONG  band = GetTagData(S2INFO_Band, 0, tags);
+						if (baselineFile)
+						{
+							struct BaselineEntry entry;
+							BOOL  hasBSSID = GetScanEntry(&net, &entry);
+							ULONG status   = ClassifyNetwork(&baseline, &entry, hasBSSID);
+
+							statusCount[status]++;
+
+							if (status != BASELINE_KNOWN)
+								Printf(" [%s]", GetBaselineStatusName(status));
+						}
 
-						Printf("%s (%s GHz)\n", ssid, band ? "2.4" : "5");
+						PutStr("\n");
 					}
 				}
 				else
 				{
-					Printf("\n%ld wireless network(s) found:\n", numNetworks);
+					Printf("\n%ld wireless network(s) found:\n", numNetworks - numEmpty);
 
-					PrintNetworkHeader();
+					PrintNetworkHeader((BOOL)(baselineFile != NULL));
 
 					for (i = 0; i < numNetworks; i++)
 					{
-						struct TagItem * tags = (struct TagItem *)buffer[i];
+						struct ScanNetwork net;
+						UBYTE row[SCANROWSIZE];
 
-						UBYTE * bssid   = (UBYTE *)GetTagData(S2INFO_BSSID, 0, tags);
-						STRPTR  ssid    = (STRPTR)GetTagData(S2INFO_SSID, (ULONG)"<hidden>", tags);
-						ULONG   channel = GetTagData(S2INFO_Channel, 0, tags);
-						LONG    signal  = GetTagData(S2INFO_Signal, -90, tags);
-						LONG    noise   = GetTagData(S2INFO_Noise, -90, tags);
-						ULONG   band    = GetTagData(S2INFO_Band, 0, tags);
-						LONG    snr     = signal - noise;
+						if (!ScanOps->sdo_DecodeNetwork((struct TagItem *)buffer[i], &net))
+							continue;
 
-						if (bssid)
-						{
-							Printf(" %4ld dB | %02lx:%02lx:%02lx:%02lx:%02lx:%02lx | %4ld | %sGHz | %s\n",
-								snr,
-								(ULONG)bssid[0], (ULONG)bssid[1],
-								(ULONG)bssid[2], (ULONG)bssid[3],
-								(ULONG)bssid[4], (ULONG)bssid[5],
-								channel,
-								band ? "2.4  " : "5    ",
-								ssid);
-						}
-						else
+						if (net.sn_Flags & SNF_TRUNCATED)
+							numTruncated++;
+
+						if (baselineFile)
 						{
-							Printf(" %4ld dB | --:--:--:--:--:-- | %4ld | %sGHz | %s\n",
-								snr,
-								channel,
-								band ? "2.4  " : "5    ",
-								ssid);
+							struct BaselineEntry entry;
+							BOOL  hasBSSID = GetScanEntry(&net, &entry);
+							ULONG status   = ClassifyNetwork(&baseline, &entry, hasBSSID);
+
+							statusCount[status]++;
+
+							Printf(" %-7s |", GetBaselineStatusName(status));
 						}
+
+						ScanOps->sdo_FormatNetworkRow(&net, row);
+						PutStr(row);
 					}
 
-					PrintSeparator();
+					PrintSeparator((BOOL)(baselineFile != NULL));
+
+					if (numTruncated)
+						Printf("\nWarning: %ld network(s) had an over-long tag list, some fields may be missing.\n", numTruncated);
+
+					if (numEmpty)
+						Printf("\nWarning: %ld empty result(s) from the driver were skipped.\n", numEmpty);
+
+					if (baselineFile)
+					{
+						Printf("\nBaseline: %ld known, %ld moved, %ld spoofed, %ld unknown\n",
+							statusCount[BASELINE_KNOWN], statusCount[BASELINE_MOVED],
+							statusCount[BASELINE_SPOOFED], statusCount[BASELINE_UNKNOWN]);
+					}
 				}
 			}
 
 			result = RETURN_OK;
+
+			/* Any access point not matching the inventory is an anomaly */
+
+			if (baselineFile && (statusCount[BASELINE_MOVED] ||
+				statusCount[BASELINE_SPOOFED] || statusCount[BASELINE_UNKNOWN]))
+			{
+				result = RETURN_WARN;
+			}
+
+			if (saveBaselineFile)
+			{
+				if (SaveBaseline(saveBaselineFile, buffer, numNetworks))
+				{
+					if (!shortMode)
+						Printf("\nBaseline saved to %s\n", saveBaselineFile);
+				}
+				else
+				{
+					Printf("\nError: Cannot write baseline '%s'.\n", saveBaselineFile);
+					result = RETURN_ERROR;
+				}
+			}
 		}
 		else
 		{
@@ -801,8 +2926,9 @@ cleanup:
 	if (msgPort)
 		DeleteMsgPort(msgPort);
 
-	if (deviceCount > 0)
-		FreeSana2DeviceNames(deviceNames, deviceCount);
+	FreeDeviceRegistry(&registry);
+
+	FreeBaseline(&baseline);
 
 	if (rdargs)
 		FreeArgs(rdargs);
@@ -0,0 +1,391 @@
+/******************************************************************************
+ *
+ * ScanDecode.c - decoding and formatting of SANA2 wireless scan results
+ *
+ * The scan results come straight from the driver, so nothing here trusts
+ * them: result counts are capped, tag lists are walked with a step limit
+ * (TAG_MORE chains may be deep or circular, TAG_SKIP counts huge), SSIDs
+ * are copied with a bound and cleaned of control characters before they
+ * reach the console.
+ *
+ * SCANDECODE_020 is defined for the 68020 and 68060 builds, which may use
+ * 32-bit divides and unaligned word/longword reads. The plain build is
+ * the 68000 one. The host harness builds both.
+ *
+ ******************************************************************************/
+
+#include <exec/types.h>
+#include <utility/tagitem.h>
+
+#include "ScanDecode.h"
+
+/*
+ * Big-endian longword and word loads from any address. The host harness
+ * supplies byte-assembling versions (host/include/HostLoad.h).
+ */
+
+#ifndef GETLONG
+#define GETLONG(p)  (*(ULONG *)(p))
+#define GETWORD(p)  (*(UWORD *)(p))
+#endif
+
+/******************************************************************************
+ *
+ * CheckScanResults() - number of S2_GETNETWORKS results safe to visit
+ *
+ ******************************************************************************/
+
+ULONG CheckScanResults(APTR * buffer, ULONG count)
+{
+	if (buffer == NULL)
+		return 0;
+
+	if (count > MAXSCANRESULTS)
+		return MAXSCANRESULTS;
+
+	return count;
+}
+
+/******************************************************************************
+ *
+ * DecodeNetwork() - extract the fields of one scan result in a single pass
+ *
+ * Like GetTagData(), the first occurrence of a tag wins. Returns FALSE if
+ * there is no tag list at all.
+ *
+ ******************************************************************************/
+
+BOOL DecodeNetwork(struct TagItem * tags, struct ScanNetwork * net)
+{
+	struct TagItem * tag = tags;
+	UBYTE * bssid = NULL;
+	UBYTE * ssid  = NULL;
+	ULONG   seen  = 0;
+	ULONG   steps = 0;
+	ULONG   i;
+
+	net->sn_Flags   = 0;
+	net->sn_SSID[0] = 0;
+	net->sn_RawSSID[0] = 0;
+	net->sn_Channel = 0;
+	net->sn_Signal  = DEFAULTSIGNAL;
+	net->sn_Noise   = DEFAULTNOISE;
+	net->sn_Band    = 0;
+
+	for (i = 0; i < 6; i++)
+		net->sn_BSSID[i] = 0;
+
+	if (tags == NULL)
+		return FALSE;
+
+	while (tag != NULL)
+	{
+		ULONG bit;
+
+		if (steps++ == MAXTAGSTEPS)
+		{
+			net->sn_Flags |= SNF_TRUNCATED;
+			break;
+		}
+
+		switch (tag->ti_Tag)
+		{
+		case TAG_DONE:
+			tag = NULL;
+			continue;
+
+		case TAG_MORE:
+			tag = (struct TagItem *)tag->ti_Data;
+			continue;
+
+		case TAG_SKIP:
+			/* Skipped items count as steps, so no skip can jump arbitrarily far */
+			if (tag->ti_Data > MAXTAGSTEPS - steps)
+			{
+				net->sn_Flags |= SNF_TRUNCATED;
+				tag = NULL;
+				continue;
+			}
+
+			steps += tag->ti_Data;
+			tag += tag->ti_Data + 1;
+			continue;
+
+		case TAG_IGNORE:
+			break;
+
+		default:
+			if (tag->ti_Tag < S2INFO_SSID || tag->ti_Tag > S2INFO_DefaultKeyNo)
+				break;
+
+			bit = 1UL << (tag->ti_Tag - S2INFO_SSID);
+
+			if (seen & bit)
+				break;
+
+			seen |= bit;
+
+			switch (tag->ti_Tag)
+			{
+			case S2INFO_SSID:    ssid  = (UBYTE *)tag->ti_Data;     break;
+			case S2INFO_BSSID:   bssid = (UBYTE *)tag->ti_Data;     break;
+			case S2INFO_Channel: net->sn_Channel = tag->ti_Data;     break;
+			case S2INFO_Signal:  net->sn_Signal  = (LONG)tag->ti_Data; net->sn_Flags |= SNF_SIGNAL; break;
+			case S2INFO_Noise:   net->sn_Noise   = (LONG)tag->ti_Data; net->sn_Flags |= SNF_NOISE;  break;
+			case S2INFO_Band:    net->sn_Band    = tag->ti_Data;     break;
+			}
+			break;
+		}
+
+		tag++;
+	}
+
+	if (bssid)
+	{
+		for (i = 0; i < 6; i++)
+			net->sn_BSSID[i] = bssid[i];
+
+		net->sn_Flags |= SNF_BSSID;
+	}
+
+	if (ssid)
+	{
+		/* Never read past MAXSSIDLEN: the SSID may not be terminated */
+
+		for (i = 0; i < MAXSSIDLEN && ssid[i]; i++)
+		{
+			UBYTE c = ssid[i];
+
+			net->sn_RawSSID[i] = c;
+
+			if (c < ' ' || (c >= 0x7f && c < 0xa0))
+				c = '?';
+
+			net->sn_SSID[i] = c;
+		}
+
+		net->sn_RawSSID[i] = 0;
+		net->sn_SSID[i] = 0;
+		net->sn_Flags |= SNF_SSID;
+	}
+
+	return TRUE;
+}
+
+/******************************************************************************
+ *
+ * PutString() / PutHex() / PutDecimal() - formatting helpers
+ *
+ ******************************************************************************/
+
+static STRPTR PutString(STRPTR p, STRPTR s)
+{
+	while (*s)
+		*p++ = *s++;
+
+	return p;
+}
+
+static STRPTR PutHex(STRPTR p, UBYTE value)
+{
+	static const UBYTE digits[] = "0123456789abcdef";
+
+	*p++ = digits[value >> 4];
+	*p++ = digits[value & 15];
+
+	return p;
+}
+
+static STRPTR PutDecimal(STRPTR p, LONG value, ULONG width)
+{
+	UBYTE   digits[12];
+	UBYTE * first;
+	UBYTE * last;
+	ULONG   magnitude = (value < 0) ? 0 - (ULONG)value : (ULONG)value;
+
+#ifdef SCANDECODE_020
+
+	first = last = &digits[sizeof(digits)];
+
+	do
+	{
+		*--first = (UBYTE)('0' + magnitude % 10);
+		magnitude /= 10;
+	}
+	while (magnitude);
+
+#else
+
+	/* The 68000 has no 32-bit divide: subtract powers of ten instead */
+
+	static const ULONG powers[] =
+	{
+		1000000000, 100000000, 10000000, 1000000, 100000,
+		10000, 1000, 100, 10, 1
+	};
+	ULONG i = 0;
+
+	while (i < 9 && magnitude < powers[i])
+		i++;
+
+	first = last = digits;
+
+	for (; i < 10; i++)
+	{
+		UBYTE digit = '0';
+
+		while (magnitude >= powers[i])
+		{
+			magnitude -= powers[i];
+			digit++;
+		}
+
+		*last++ = digit;
+	}
+
+#endif
+
+	if (value < 0 && width > 0)
+		width--;
+
+	while (width > (ULONG)(last - first))
+	{
+		*p++ = ' ';
+		width--;
+	}
+
+	if (value < 0)
+		*p++ = '-';
+
+	while (first < last)
+		*p++ = *first++;
+
+	return p;
+}
+
+/******************************************************************************
+ *
+ * FormatNetworkRow() - one line of the network table, returns its length
+ *
+ * buffer must hold SCANROWSIZE bytes.
+ *
+ ******************************************************************************/
+
+ULONG FormatNetworkRow(struct ScanNetwork * net, STRPTR buffer)
+{
+	STRPTR p = buffer;
+	ULONG  i;
+
+	*p++ = ' ';
+	p = PutDecimal(p, (LONG)((ULONG)net->sn_Signal - (ULONG)net->sn_Noise), 4);
+	p = PutString(p, " dB | ");
+
+	for (i = 0; i < 6; i++)
+	{
+		if (i > 0)
+			*p++ = ':';
+
+		if (net->sn_Flags & SNF_BSSID)
+			p = PutHex(p, net->sn_BSSID[i]);
+		else
+			p = PutString(p, "--");
+	}
+
+	p = PutString(p, " | ");
+	p = PutDecimal(p, (LONG)net->sn_Channel, 4);
+	p = PutString(p, net->sn_Band ? " | 2.4  GHz | " : " | 5    GHz | ");
+	p = PutString(p, (net->sn_Flags & SNF_SSID) ? net->sn_SSID : (UBYTE *)"<hidden>");
+	*p++ = '\n';
+	*p = 0;
+
+	return (ULONG)(p - buffer);
+}
+
+/******************************************************************************
+ *
+ * CompareBSSID()
+ *
+ ******************************************************************************/
+
+static LONG CompareBSSID(UBYTE * a, UBYTE * b)
+{
+#ifdef SCANDECODE_020
+
+	/* Big-endian, so comparing words compares bytes in order */
+
+	if (GETLONG(a) != GETLONG(b))
+		return (GETLONG(a) > GETLONG(b)) ? 1 : -1;
+
+	return (LONG)GETWORD(a + 4) - (LONG)GETWORD(b + 4);
+
+#else
+
+	/* No unaligned word reads on the 68000 */
+
+	ULONG i;
+
+	for (i = 0; i < 6; i++)
+	{
+		if (a[i] != b[i])
+			return (LONG)a[i] - (LONG)b[i];
+	}
+
+	return 0;
+
+#endif
+}
+
+/******************************************************************************
+ *
+ * SortByBSSID() - shell sort of structure pointers on a BSSID at offset
+ *
+ * The gaps come from a table so no multiply or divide is needed.
+ *
+ ******************************************************************************/
+
+VOID SortByBSSID(APTR * array, ULONG count, ULONG offset)
+{
+	static const ULONG gaps[] =
+	{
+		88573, 29524, 9841, 3280, 1093, 364, 121, 40, 13, 4, 1
+	};
+	ULONG g, i, j;
+
+	for (g = 0; g < sizeof(gaps) / sizeof(gaps[0]); g++)
+	{
+		ULONG gap = gaps[g];
+
+		for (i = gap; i < count; i++)
+		{
+			APTR    item = array[i];
+			UBYTE * key  = (UBYTE *)item + offset;
+
+			for (j = i; j >= gap && CompareBSSID((UBYTE *)array[j - gap] + offset, key) > 0; j -= gap)
+				array[j] = array[j - gap];
+
+			array[j] = item;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * Function table of this CPU build
+ *
+ ******************************************************************************/
+
+#ifdef SCANDECODE_CPU
+
+#define SCANDECODE_STR(a)     #a
+#define SCANDECODE_CPUNAME(a) "68" SCANDECODE_STR(a)
+
+struct ScanDecodeOps ScanDecodeThisCPU =
+{
+	SCANDECODE_CPUNAME(SCANDECODE_CPU),
+	CheckScanResults,
+	DecodeNetwork,
+	FormatNetworkRow,
+	SortByBSSID
+};
+
+#endif /* SCANDECODE_CPU */
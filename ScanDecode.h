@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ * ScanDecode.h - decoding and formatting of SANA2 wireless scan results
+ *
+ * Kept free of library calls so the same code can be built on the host
+ * by the stress harness in host/.
+ *
+ * On the Amiga, ScanDecode.c is compiled once per CPU (see SMakeFile) with
+ * SCANDECODE_CPU set to 000, 020 or 060. Each build gets its own function
+ * names and a struct ScanDecodeOps table; the program picks one at startup
+ * from SysBase->AttnFlags and calls the hot paths through it.
+ *
+ ******************************************************************************/
+
+#ifndef SCANDECODE_H
+#define SCANDECODE_H
+
+/******************************************************************************
+ *
+ * SANA2 Wireless definitions
+ * (from devices/sana2wireless.h - not present in all SDK installations)
+ *
+ ******************************************************************************/
+
+#ifndef S2_GETSIGNALQUALITY
+
+/* Wireless commands */
+#define S2_GETSIGNALQUALITY 0xC010
+#define S2_GETNETWORKS      0xC011
+#define S2_SETOPTIONS       0xC012
+#define S2_SETKEY           0xC013
+#define S2_GETNETWORKINFO   0xC014
+#define S2_READMGMT         0xC015
+#define S2_WRITEMGMT        0xC016
+#define S2_GETCRYPTTYPES    0xC017
+
+/* Tags for getting/setting wireless network info */
+#define S2INFO_SSID             (TAG_USER + 0)
+#define S2INFO_BSSID            (TAG_USER + 1)
+#define S2INFO_AuthTypes        (TAG_USER + 2)
+#define S2INFO_AssocID          (TAG_USER + 3)
+#define S2INFO_Encryption       (TAG_USER + 4)
+#define S2INFO_PortType         (TAG_USER + 5)
+#define S2INFO_BeaconInterval   (TAG_USER + 6)
+#define S2INFO_Channel          (TAG_USER + 7)
+#define S2INFO_Signal           (TAG_USER + 8)
+#define S2INFO_Noise            (TAG_USER + 9)
+#define S2INFO_Capabilities     (TAG_USER + 10)
+#define S2INFO_InfoElements     (TAG_USER + 11)
+#define S2INFO_WPAInfo          (TAG_USER + 12)
+#define S2INFO_Band             (TAG_USER + 13)
+#define S2INFO_DefaultKeyNo     (TAG_USER + 14)
+
+/* Encryption types */
+#define S2ENC_NONE  0
+#define S2ENC_WEP   1
+#define S2ENC_TKIP  2
+#define S2ENC_CCMP  3
+
+/* Signal quality structure */
+struct Sana2SignalQuality
+{
+	LONG SignalLevel;
+	LONG NoiseLevel;
+};
+
+#endif /* S2_GETSIGNALQUALITY */
+
+/******************************************************************************
+ *
+ * Defines
+ *
+ ******************************************************************************/
+
+#define MAXSSIDLEN      32
+#define MAXSCANRESULTS  1024  /* ios2_DataLength beyond this is not trusted */
+#define MAXTAGSTEPS     256   /* tag items visited or skipped per network, TAG_MORE included */
+#define SCANROWSIZE     128   /* FormatNetworkRow() output, NUL included */
+
+#define DEFAULTSIGNAL   -90
+#define DEFAULTNOISE    -90
+
+/* ScanNetwork flags */
+#define SNF_BSSID       (1 << 0)
+#define SNF_SSID        (1 << 1)
+#define SNF_TRUNCATED   (1 << 2)  /* tag walk stopped at MAXTAGSTEPS, skips included */
+#define SNF_SIGNAL      (1 << 3)  /* sn_Signal from the driver, not DEFAULTSIGNAL */
+#define SNF_NOISE       (1 << 4)  /* sn_Noise from the driver, not DEFAULTNOISE */
+
+#define OFFSETOF(type, field) ((ULONG)&((type *)0)->field)
+
+/******************************************************************************
+ *
+ * One decoded scan result
+ *
+ ******************************************************************************/
+
+struct ScanNetwork
+{
+	UBYTE sn_Flags;
+	UBYTE sn_BSSID[6];
+	UBYTE sn_SSID[MAXSSIDLEN + 1];  /* printable characters only */
+	UBYTE sn_RawSSID[MAXSSIDLEN + 1];  /* as sent by the driver, for comparisons */
+	ULONG sn_Channel;
+	LONG  sn_Signal;
+	LONG  sn_Noise;
+	ULONG sn_Band;
+};
+
+/******************************************************************************
+ *
+ * Per-CPU builds
+ *
+ ******************************************************************************/
+
+struct ScanDecodeOps
+{
+	STRPTR sdo_Name;
+	ULONG  (*sdo_CheckScanResults)(APTR * buffer, ULONG count);
+	BOOL   (*sdo_DecodeNetwork)(struct TagItem * tags, struct ScanNetwork * net);
+	ULONG  (*sdo_FormatNetworkRow)(struct ScanNetwork * net, STRPTR buffer);
+	VOID   (*sdo_SortByBSSID)(APTR * array, ULONG count, ULONG offset);
+};
+
+#ifdef SCANDECODE_CPU
+
+#define SCANDECODE_PASTE(a, b)  a ## b
+#define SCANDECODE_NAME(a, b)   SCANDECODE_PASTE(a, b)
+
+#define CheckScanResults        SCANDECODE_NAME(CheckScanResults, SCANDECODE_CPU)
+#define DecodeNetwork           SCANDECODE_NAME(DecodeNetwork, SCANDECODE_CPU)
+#define FormatNetworkRow        SCANDECODE_NAME(FormatNetworkRow, SCANDECODE_CPU)
+#define SortByBSSID             SCANDECODE_NAME(SortByBSSID, SCANDECODE_CPU)
+#define ScanDecodeThisCPU       SCANDECODE_NAME(ScanDecode, SCANDECODE_CPU)
+
+#endif /* SCANDECODE_CPU */
+
+extern struct ScanDecodeOps ScanDecode000;
+extern struct ScanDecodeOps ScanDecode020;
+extern struct ScanDecodeOps ScanDecode060;
+
+/******************************************************************************
+ *
+ * Prototypes
+ *
+ ******************************************************************************/
+
+ULONG CheckScanResults(APTR * buffer, ULONG count);
+BOOL  DecodeNetwork(struct TagItem * tags, struct ScanNetwork * net);
+ULONG FormatNetworkRow(struct ScanNetwork * net, STRPTR buffer);
+VOID  SortByBSSID(APTR * array, ULONG count, ULONG offset);
+
+#endif /* SCANDECODE_H */
@@ -0,0 +1,762 @@
+/******************************************************************************
+ *
+ * FuzzScanDecode - host stress and fuzz harness for ScanDecode.c
+ *
+ * Feeds CheckScanResults(), DecodeNetwork(), FormatNetworkRow() and
+ * SortByBSSID() with
+ * randomly generated and adversarial S2_GETNETWORKS results: huge result
+ * counts, NULL buffers and tag lists, deep and circular TAG_MORE chains,
+ * TAG_SKIP/TAG_IGNORE runs, huge TAG_SKIP counts, duplicate and unknown
+ * tags, missing, oversized, unterminated and control character SSIDs,
+ * extreme signal levels. SNF_TRUNCATED must be set exactly when the walk
+ * hits MAXTAGSTEPS.
+ *
+ * Unterminated SSIDs and BSSIDs, and tag lists ending in a huge TAG_SKIP,
+ * are placed right before a PROT_NONE page, so reading a single byte (or
+ * tag item) too far crashes. Crashes and hangs report the
+ * seed of the failing scan; re-run it alone with "FuzzScanDecode <seed> 1".
+ *
+ * Built once per decoder variant: FuzzScanDecode for the 68000 code paths,
+ * FuzzScanDecode020 (SCANDECODE_020) for the 68020/68060 ones.
+ *
+ * Usage: FuzzScanDecode [seed [scans]]
+ *
+ ******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <exec/types.h>
+#include <utility/tagitem.h>
+
+#include "ScanDecode.h"
+
+/******************************************************************************
+ *
+ * Defines
+ *
+ ******************************************************************************/
+
+#ifdef SCANDECODE_020
+#define VARIANT       "68020"
+#else
+#define VARIANT       "68000"
+#endif
+
+#define DEFAULTSEED   1
+#define DEFAULTSCANS  5000
+#define MAXCHAIN      (2 * MAXTAGSTEPS)  /* TAG_MORE segments in a deep chain */
+#define ARENASIZE     (64UL << 20)
+#define TIMEOUTSECS   5      /* a single scan taking longer is a hang    */
+#define CANARY        0xa5
+#define CANARYSIZE    16
+
+/******************************************************************************
+ *
+ * Globals (read by the signal handlers)
+ *
+ ******************************************************************************/
+
+static volatile unsigned long currentSeed;
+
+static UBYTE * ssidGuard;    /* last readable byte is ssidGuard[pageSize - 1]  */
+static UBYTE * bssidGuard;   /* last readable byte is bssidGuard[pageSize - 1] */
+static UBYTE * tagGuard;     /* last readable byte is tagGuard[pageSize - 1]   */
+static size_t  pageSize;
+
+/******************************************************************************
+ *
+ * Random numbers - xorshift32, reproducible across hosts
+ *
+ ******************************************************************************/
+
+static unsigned long rngState;
+
+static unsigned long Random(void)
+{
+	unsigned long x = rngState;
+
+	x ^= (x << 13) & 0xffffffffUL;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xffffffffUL;
+
+	return rngState = x & 0xffffffffUL;
+}
+
+static unsigned long RandomRange(unsigned long n)
+{
+	return n ? Random() % n : 0;
+}
+
+/******************************************************************************
+ *
+ * Arena - bump allocator for one scan, released in one go
+ *
+ ******************************************************************************/
+
+struct Arena
+{
+	UBYTE * base;
+	size_t  used;
+};
+
+static void * ArenaAlloc(struct Arena * arena, size_t size)
+{
+	void * block;
+
+	size = (size + 15) & ~(size_t)15;
+
+	if (arena->used + size > ARENASIZE)
+	{
+		fprintf(stderr, "FuzzScanDecode: arena exhausted in scan with seed %lu\n", currentSeed);
+		exit(3);
+	}
+
+	block = arena->base + arena->used;
+	arena->used += size;
+
+	return memset(block, 0, size);
+}
+
+static void ArenaFree(struct Arena * arena)
+{
+	arena->used = 0;
+}
+
+/******************************************************************************
+ *
+ * Signal handlers - report the seed and bail out
+ *
+ ******************************************************************************/
+
+static void Report(const char * what)
+{
+	char buffer[64];
+	char digits[24];
+	unsigned long seed = currentSeed;
+	size_t len = strlen(what);
+	int count = 0;
+
+	memcpy(buffer, what, len);
+
+	do
+	{
+		digits[count++] = (char)('0' + seed % 10);
+		seed /= 10;
+	}
+	while (seed);
+
+	while (count)
+		buffer[len++] = digits[--count];
+
+	buffer[len++] = '\n';
+
+	(void)write(2, buffer, len);
+}
+
+static void CrashHandler(int sig)
+{
+	(void)sig;
+	Report("FAIL: crash in scan with seed ");
+	_exit(1);
+}
+
+static void TimeoutHandler(int sig)
+{
+	(void)sig;
+	Report("FAIL: no progress in scan with seed ");
+	_exit(2);
+}
+
+/******************************************************************************
+ *
+ * Generators
+ *
+ ******************************************************************************/
+
+static UBYTE * MakeBSSID(struct Arena * arena)
+{
+	UBYTE * bssid;
+	int i;
+
+	switch (RandomRange(4))
+	{
+	case 0:
+		return NULL;
+
+	case 1:
+		/* Exactly 6 readable bytes */
+		bssid = bssidGuard + pageSize - 6;
+		break;
+
+	default:
+		bssid = ArenaAlloc(arena, 6);
+		break;
+	}
+
+	for (i = 0; i < 6; i++)
+		bssid[i] = (UBYTE)Random();
+
+	/* Half share a site prefix, so sorts get to the last two bytes */
+
+	if (RandomRange(2))
+	{
+		bssid[0] = 0x00;
+		bssid[1] = 0x11;
+		bssid[2] = 0x22;
+		bssid[3] = (UBYTE)RandomRange(2);
+		bssid[4] = (UBYTE)RandomRange(4) << 6;
+	}
+
+	return bssid;
+}
+
+static UBYTE * MakeSSID(struct Arena * arena)
+{
+	UBYTE * ssid;
+	unsigned long len;
+	unsigned long i;
+
+	switch (RandomRange(7))
+	{
+	case 0:
+		return NULL;
+
+	case 1:
+		return (UBYTE *)"";
+
+	case 2:
+		/* MAXSSIDLEN bytes and no terminator before the guard page */
+		ssid = ssidGuard + pageSize - MAXSSIDLEN;
+
+		for (i = 0; i < MAXSSIDLEN; i++)
+			ssid[i] = (UBYTE)('A' + RandomRange(26));
+
+		return ssid;
+
+	case 3:
+		/* Console control sequences */
+		len  = 1 + RandomRange(MAXSSIDLEN * 2);
+		ssid = ArenaAlloc(arena, len + 1);
+
+		for (i = 0; i < len; i++)
+			ssid[i] = (UBYTE)(RandomRange(2) ? 0x1b : 0x9b);
+
+		return ssid;
+
+	case 4:
+		/* Oversized */
+		len  = MAXSSIDLEN + 1 + RandomRange(1024);
+		ssid = ArenaAlloc(arena, len + 1);
+
+		for (i = 0; i < len; i++)
+			ssid[i] = (UBYTE)('a' + RandomRange(26));
+
+		return ssid;
+
+	default:
+		/* Any non-zero bytes */
+		len  = RandomRange(MAXSSIDLEN + 1);
+		ssid = ArenaAlloc(arena, len + 1);
+
+		for (i = 0; i < len; i++)
+			ssid[i] = (UBYTE)(1 + RandomRange(255));
+
+		return ssid;
+	}
+}
+
+static ULONG MakeValue(void)
+{
+	switch (RandomRange(5))
+	{
+	case 0:  return 0;
+	case 1:  return 0x7fffffffUL;
+	case 2:  return (ULONG)-0x7fffffffL - 1;
+	case 3:  return (ULONG)-(long)RandomRange(100);
+	default: return Random();
+	}
+}
+
+static void MakeItem(struct Arena * arena, struct TagItem * item)
+{
+	unsigned long kind = RandomRange(12);
+
+	if (kind < 10)
+	{
+		/* Pointer tags are drawn more often than their share */
+		item->ti_Tag = (kind < 4) ? S2INFO_SSID + (kind & 1) : S2INFO_SSID + RandomRange(15);
+
+		switch (item->ti_Tag)
+		{
+		case S2INFO_SSID:  item->ti_Data = (ULONG)MakeSSID(arena);  break;
+		case S2INFO_BSSID: item->ti_Data = (ULONG)MakeBSSID(arena); break;
+		default:           item->ti_Data = MakeValue();             break;
+		}
+	}
+	else if (kind == 10)
+	{
+		item->ti_Tag  = TAG_IGNORE;
+		item->ti_Data = Random();
+	}
+	else
+	{
+		/* Unknown tag, never one of the control tags */
+		item->ti_Tag  = 4 + RandomRange(0x7ffffff0UL) + (RandomRange(2) ? TAG_USER : 0);
+		item->ti_Data = Random();
+	}
+}
+
+/* A TAG_SKIP past anything MAXTAGSTEPS allows, wherever it is in the walk */
+
+static void MakeHugeSkip(struct TagItem * item)
+{
+	item->ti_Tag = TAG_SKIP;
+
+	switch (RandomRange(3))
+	{
+	case 0:  item->ti_Data = 0xffffffffUL;                                break;
+	case 1:  item->ti_Data = MAXTAGSTEPS + 1;                             break;
+	default: item->ti_Data = MAXTAGSTEPS + 1 + RandomRange(0x7fffffffUL); break;
+	}
+}
+
+/*
+ * A list of n ordinary items, with some TAG_SKIPs that stay inside it
+ * and, rarely, a huge one that does not.
+ * Ends with TAG_DONE, which chain builders turn into TAG_MORE.
+ */
+
+static struct TagItem * MakeSegment(struct Arena * arena, unsigned long n)
+{
+	struct TagItem * list = ArenaAlloc(arena, (n + 1) * sizeof(struct TagItem));
+	unsigned long i;
+
+	for (i = 0; i < n; i++)
+	{
+		unsigned long left = n - i - 1;
+
+		if (left > 0 && RandomRange(8) == 0)
+		{
+			unsigned long skip = 1 + RandomRange(left);
+			unsigned long j;
+
+			list[i].ti_Tag  = TAG_SKIP;
+			list[i].ti_Data = skip;
+
+			for (j = 1; j <= skip; j++)
+				MakeItem(arena, &list[i + j]);
+
+			i += skip;
+		}
+		else if (RandomRange(64) == 0)
+		{
+			MakeHugeSkip(&list[i]);
+		}
+		else
+		{
+			MakeItem(arena, &list[i]);
+		}
+	}
+
+	list[n].ti_Tag  = TAG_DONE;
+	list[n].ti_Data = 0;
+
+	return list;
+}
+
+static struct TagItem * MakeTagList(struct Arena * arena, unsigned long mode)
+{
+	struct TagItem * head;
+	struct TagItem * tail;
+	unsigned long length;
+	unsigned long i;
+
+	switch (mode)
+	{
+	case 0:
+		return NULL;
+
+	case 1:
+	case 2:
+		/* Deep chain, optionally closed into a loop */
+		length = 1 + RandomRange(MAXCHAIN);
+		head = tail = MakeSegment(arena, 1 + RandomRange(3));
+
+		for (i = 1; i < length; i++)
+		{
+			struct TagItem * next = MakeSegment(arena, 1 + RandomRange(3));
+
+			while (tail->ti_Tag != TAG_DONE)
+				tail++;
+
+			tail->ti_Tag  = TAG_MORE;
+			tail->ti_Data = (ULONG)next;
+			tail = next;
+		}
+
+		if (mode == 2)
+		{
+			while (tail->ti_Tag != TAG_DONE)
+				tail++;
+
+			tail->ti_Tag  = TAG_MORE;
+			tail->ti_Data = (ULONG)head;
+		}
+
+		return head;
+
+	case 3:
+		/* A few items, then a huge TAG_SKIP as the last item before the guard page */
+		length = 1 + RandomRange(4);
+		head = (struct TagItem *)(tagGuard + pageSize) - length;
+
+		for (i = 0; i + 1 < length; i++)
+			MakeItem(arena, &head[i]);
+
+		MakeHugeSkip(&head[length - 1]);
+
+		return head;
+
+	default:
+		return MakeSegment(arena, RandomRange(24));
+	}
+}
+
+/******************************************************************************
+ *
+ * ExpectTruncated() - whether the walk of a tag list must hit MAXTAGSTEPS
+ *
+ * Every item visited or skipped is one step; a skip that would take the
+ * walk past the limit ends it right there.
+ *
+ ******************************************************************************/
+
+static int ExpectTruncated(struct TagItem * tag)
+{
+	ULONG steps = 0;
+
+	while (tag != NULL)
+	{
+		if (steps++ == MAXTAGSTEPS)
+			return 1;
+
+		switch (tag->ti_Tag)
+		{
+		case TAG_DONE:
+			return 0;
+
+		case TAG_MORE:
+			tag = (struct TagItem *)tag->ti_Data;
+			continue;
+
+		case TAG_SKIP:
+			if (tag->ti_Data > MAXTAGSTEPS - steps)
+				return 1;
+
+			steps += tag->ti_Data;
+			tag   += tag->ti_Data + 1;
+			continue;
+		}
+
+		tag++;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * CheckNetwork() - decode and format one result, verify the output
+ *
+ ******************************************************************************/
+
+static int CheckNetwork(struct TagItem * tags, struct ScanNetwork * decoded)
+{
+	struct ScanNetwork net;
+	UBYTE row[SCANROWSIZE + CANARYSIZE];
+	char  expected[SCANROWSIZE * 2];
+	ULONG len;
+	ULONG i;
+
+	memset(row, CANARY, sizeof(row));
+
+	if (!DecodeNetwork(tags, &net))
+	{
+		if (tags != NULL)
+			return 0;
+
+		return 1;
+	}
+
+	*decoded = net;
+
+	if (((net.sn_Flags & SNF_TRUNCATED) != 0) != ExpectTruncated(tags))
+		return 0;
+
+	for (i = 0; i <= MAXSSIDLEN && net.sn_SSID[i]; i++)
+	{
+		if (net.sn_SSID[i] < ' ' || (net.sn_SSID[i] >= 0x7f && net.sn_SSID[i] < 0xa0))
+			return 0;
+	}
+
+	if (i > MAXSSIDLEN)
+		return 0;
+
+	/* The raw copy has the same length and differs only where cleaned */
+
+	for (i = 0; i <= MAXSSIDLEN && net.sn_SSID[i]; i++)
+	{
+		if (net.sn_RawSSID[i] == 0 || (net.sn_RawSSID[i] != net.sn_SSID[i] && net.sn_SSID[i] != '?'))
+			return 0;
+	}
+
+	if (net.sn_RawSSID[i] != 0)
+		return 0;
+
+	len = FormatNetworkRow(&net, row);
+
+	if (len >= SCANROWSIZE || strlen((char *)row) != len || row[len - 1] != '\n')
+		return 0;
+
+	for (i = SCANROWSIZE; i < sizeof(row); i++)
+	{
+		if (row[i] != CANARY)
+			return 0;
+	}
+
+	for (i = 0; i < len - 1; i++)
+	{
+		if (row[i] < ' ' || (row[i] >= 0x7f && row[i] < 0xa0))
+			return 0;
+	}
+
+	/*
+	 * Same text as the Printf() format the table used to be printed with.
+	 *
+	 * The SNR is computed in host ULONGs like FormatNetworkRow() does. On a
+	 * 64-bit host that difference does not wrap at 32 bits, so for extreme
+	 * levels the expected (and decoded) value is not the one the Amiga
+	 * would print; the row width and digits are still checked.
+	 */
+
+	if (net.sn_Flags & SNF_BSSID)
+	{
+		snprintf(expected, sizeof(expected), " %4ld dB | %02x:%02x:%02x:%02x:%02x:%02x | %4ld | %sGHz | %s\n",
+			(LONG)((ULONG)net.sn_Signal - (ULONG)net.sn_Noise),
+			net.sn_BSSID[0], net.sn_BSSID[1], net.sn_BSSID[2],
+			net.sn_BSSID[3], net.sn_BSSID[4], net.sn_BSSID[5],
+			(LONG)net.sn_Channel,
+			net.sn_Band ? "2.4  " : "5    ",
+			(net.sn_Flags & SNF_SSID) ? (char *)net.sn_SSID : "<hidden>");
+	}
+	else
+	{
+		snprintf(expected, sizeof(expected), " %4ld dB | --:--:--:--:--:-- | %4ld | %sGHz | %s\n",
+			(LONG)((ULONG)net.sn_Signal - (ULONG)net.sn_Noise),
+			(LONG)net.sn_Channel,
+			net.sn_Band ? "2.4  " : "5    ",
+			(net.sn_Flags & SNF_SSID) ? (char *)net.sn_SSID : "<hidden>");
+	}
+
+	return strcmp(expected, (char *)row) == 0;
+}
+
+/******************************************************************************
+ *
+ * CheckSort() - sort the decoded results by BSSID, verify the order
+ *
+ ******************************************************************************/
+
+static int CheckSort(struct ScanNetwork * nets, APTR * index, ULONG count)
+{
+	ULONG i;
+
+	for (i = 0; i < count; i++)
+		index[i] = &nets[count - 1 - i];
+
+	SortByBSSID(index, count, OFFSETOF(struct ScanNetwork, sn_BSSID));
+
+	for (i = 1; i < count; i++)
+	{
+		if (memcmp(((struct ScanNetwork *)index[i - 1])->sn_BSSID,
+			((struct ScanNetwork *)index[i])->sn_BSSID, 6) > 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *
+ * RunScan() - generate and check one adversarial scan, returns nanoseconds
+ *
+ ******************************************************************************/
+
+static long RunScan(struct Arena * arena, unsigned long * networks)
+{
+	struct timespec t0, t1;
+	struct ScanNetwork * nets;
+	APTR * index;
+	APTR * buffer;
+	ULONG claimed;
+	ULONG actual;
+	ULONG count;
+	ULONG i;
+	unsigned long shape = RandomRange(16);
+	unsigned long mode;
+
+	/* Result count reported by the driver vs entries really present */
+
+	switch (shape)
+	{
+	case 0:
+		buffer  = NULL;
+		claimed = Random();
+		actual  = 0;
+		break;
+
+	case 1:
+	case 2:
+		claimed = RandomRange(2) ? 0xffffffffUL : MAXSCANRESULTS + 1 + RandomRange(100000);
+		actual  = MAXSCANRESULTS;
+		buffer  = ArenaAlloc(arena, actual * sizeof(APTR));
+		break;
+
+	default:
+		claimed = actual = RandomRange(64);
+		buffer  = ArenaAlloc(arena, (actual + 1) * sizeof(APTR));
+		break;
+	}
+
+	for (i = 0; i < actual; i++)
+	{
+		/* Worst case: every result is the same circular chain */
+		if (shape == 1)
+		{
+			buffer[i] = i ? buffer[0] : MakeTagList(arena, 2);
+			continue;
+		}
+
+		mode = RandomRange(16);
+		buffer[i] = MakeTagList(arena, mode < 4 ? mode : 4);
+	}
+
+	nets  = ArenaAlloc(arena, (actual + 1) * sizeof(struct ScanNetwork));
+	index = ArenaAlloc(arena, (actual + 1) * sizeof(APTR));
+
+	alarm(TIMEOUTSECS);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	count = CheckScanResults(buffer, claimed);
+
+	if (count > actual)
+	{
+		Report("FAIL: result count not capped in scan with seed ");
+		exit(1);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		if (!CheckNetwork((struct TagItem *)buffer[i], &nets[i]))
+		{
+			Report("FAIL: bad decode or row in scan with seed ");
+			exit(1);
+		}
+	}
+
+	if (!CheckSort(nets, index, count))
+	{
+		Report("FAIL: bad BSSID order in scan with seed ");
+		exit(1);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	alarm(0);
+
+	*networks += count;
+
+	return (t1.tv_sec - t0.tv_sec) * 1000000000L + (t1.tv_nsec - t0.tv_nsec);
+}
+
+/******************************************************************************
+ *
+ * main()
+ *
+ ******************************************************************************/
+
+int main(int argc, char ** argv)
+{
+	struct Arena arena = { NULL, 0 };
+	unsigned long seed  = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULTSEED;
+	unsigned long scans = (argc > 2) ? strtoul(argv[2], NULL, 0) : DEFAULTSCANS;
+	unsigned long networks = 0;
+	unsigned long worstSeed = seed;
+	long worst = 0;
+	unsigned long n;
+
+	pageSize = (size_t)sysconf(_SC_PAGESIZE);
+
+	/* [ssid page][no access][bssid page][no access][tag page][no access] */
+
+	ssidGuard = mmap(NULL, 6 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (ssidGuard == MAP_FAILED ||
+		mprotect(ssidGuard + pageSize, pageSize, PROT_NONE) != 0 ||
+		mprotect(ssidGuard + 3 * pageSize, pageSize, PROT_NONE) != 0 ||
+		mprotect(ssidGuard + 5 * pageSize, pageSize, PROT_NONE) != 0)
+	{
+		perror("mmap");
+		return 3;
+	}
+
+	bssidGuard = ssidGuard + 2 * pageSize;
+	tagGuard   = ssidGuard + 4 * pageSize;
+
+	if ((arena.base = malloc(ARENASIZE)) == NULL)
+	{
+		perror("malloc");
+		return 3;
+	}
+
+	signal(SIGSEGV, CrashHandler);
+	signal(SIGBUS, CrashHandler);
+	signal(SIGALRM, TimeoutHandler);
+
+	for (n = 0; n < scans; n++)
+	{
+		long elapsed;
+
+		/* Each scan has its own seed so any failure replays alone */
+		currentSeed = (seed + n) & 0xffffffffUL;
+		rngState    = currentSeed ? currentSeed : 0x9e3779b9UL;
+
+		elapsed = RunScan(&arena, &networks);
+
+		if (elapsed > worst)
+		{
+			worst     = elapsed;
+			worstSeed = currentSeed;
+		}
+
+		ArenaFree(&arena);
+	}
+
+	printf("FuzzScanDecode (" VARIANT "): %lu scans, %lu results decoded, seeds %lu..%lu\n",
+		scans, networks, seed, seed + scans - 1);
+	printf("Worst-case scan decode: %ld us (seed %lu), bound %d results x %d tag steps\n",
+		worst / 1000, worstSeed, MAXSCANRESULTS, MAXTAGSTEPS);
+
+	free(arena.base);
+
+	return 0;
+}
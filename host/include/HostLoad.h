@@ -0,0 +1,21 @@
+/******************************************************************************
+ *
+ * HostLoad.h - big-endian loads for building ScanDecode.c off-Amiga
+ *
+ * The 68020 code reads BSSIDs a longword and a word at a time. On the
+ * Amiga those are plain big-endian loads; here they are assembled from
+ * bytes, so the same ordering logic runs on any host byte order.
+ *
+ ******************************************************************************/
+
+#ifndef HOSTLOAD_H
+#define HOSTLOAD_H
+
+#define GETLONG(p) \
+	(((ULONG)((UBYTE *)(p))[0] << 24) | ((ULONG)((UBYTE *)(p))[1] << 16) | \
+	 ((ULONG)((UBYTE *)(p))[2] << 8)  |  (ULONG)((UBYTE *)(p))[3])
+
+#define GETWORD(p) \
+	((UWORD)(((UWORD)((UBYTE *)(p))[0] << 8) | ((UBYTE *)(p))[1]))
+
+#endif /* HOSTLOAD_H */
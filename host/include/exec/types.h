@@ -0,0 +1,31 @@
+/******************************************************************************
+ *
+ * exec/types.h - minimal host stand-in for building ScanDecode.c off-Amiga
+ *
+ * ULONG is a native long so that ti_Data can carry a host pointer. On a
+ * 64-bit host LONG and ULONG arithmetic therefore does not wrap at 32 bits
+ * as it does on the Amiga (see FuzzScanDecode.c, CheckNetwork()).
+ *
+ ******************************************************************************/
+
+#ifndef EXEC_TYPES_H
+#define EXEC_TYPES_H
+
+#include <stddef.h>
+
+#define VOID void
+
+typedef void *          APTR;
+typedef long            LONG;
+typedef unsigned long   ULONG;
+typedef short           WORD;
+typedef unsigned short  UWORD;
+typedef signed char     BYTE;
+typedef unsigned char   UBYTE;
+typedef short           BOOL;
+typedef unsigned char * STRPTR;
+
+#define TRUE  1
+#define FALSE 0
+
+#endif /* EXEC_TYPES_H */
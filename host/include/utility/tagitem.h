@@ -0,0 +1,27 @@
+/******************************************************************************
+ *
+ * utility/tagitem.h - minimal host stand-in for building ScanDecode.c off-Amiga
+ *
+ ******************************************************************************/
+
+#ifndef UTILITY_TAGITEM_H
+#define UTILITY_TAGITEM_H
+
+#include <exec/types.h>
+
+typedef ULONG Tag;
+
+struct TagItem
+{
+	Tag   ti_Tag;
+	ULONG ti_Data;
+};
+
+#define TAG_DONE   0UL
+#define TAG_END    0UL
+#define TAG_IGNORE 1UL
+#define TAG_MORE   2UL
+#define TAG_SKIP   3UL
+#define TAG_USER   (1UL << 31)
+
+#endif /* UTILITY_TAGITEM_H */